@@ -0,0 +1,128 @@
+#include "abr-controller.h"
+
+#include <algorithm>
+#include <sstream>
+#include <cstdlib>
+
+namespace ns3 {
+
+AbrController::AbrController ()
+	: m_level (0),
+	  m_packetSize (0),
+	  m_fps (0),
+	  m_safety (0.9)
+{
+}
+
+std::vector<uint32_t>
+AbrController::ParseLadder (const std::string &levels)
+{
+	std::vector<uint32_t> ladder;
+	std::stringstream ss (levels);
+	std::string item;
+	while (std::getline (ss, item, ','))
+	{
+		uint32_t packets = std::strtoul (item.c_str (), 0, 10);
+		if (packets > 0)
+			ladder.push_back (packets);
+	}
+	std::sort (ladder.begin (), ladder.end ());
+	ladder.erase (std::unique (ladder.begin (), ladder.end ()), ladder.end ());
+	return ladder;
+}
+
+void
+AbrController::SetLadder (const std::vector<uint32_t> &ladder)
+{
+	m_ladder = ladder;
+	// start at the top, as the fixed-rate stream did
+	m_level = m_ladder.empty () ? 0 : m_ladder.size () - 1;
+}
+
+void
+AbrController::SetStreamParameters (uint32_t packetSize, double fps)
+{
+	m_packetSize = packetSize;
+	m_fps = fps;
+}
+
+void
+AbrController::SetSafetyFactor (double safety)
+{
+	m_safety = safety;
+}
+
+bool
+AbrController::IsEnabled (void) const
+{
+	return m_ladder.size () > 1;
+}
+
+uint32_t
+AbrController::GetLevelCount (void) const
+{
+	return m_ladder.size ();
+}
+
+uint8_t
+AbrController::GetLevel (void) const
+{
+	return m_level;
+}
+
+uint32_t
+AbrController::GetFramePackets (uint8_t level) const
+{
+	return m_ladder[level];
+}
+
+double
+AbrController::GetBitrate (uint8_t level) const
+{
+	return m_ladder[level] * m_packetSize * 8.0 * m_fps;
+}
+
+uint8_t
+AbrController::Update (double throughput, uint32_t bufferedFrames,
+                       uint32_t lowFrames, uint32_t highFrames)
+{
+	if (!IsEnabled ())
+		return m_level;
+
+	// the streamer is held back by flow control, so throughput says
+	// nothing about the link
+	if (bufferedFrames >= highFrames)
+		return m_level;
+
+	// a level is sustainable while what arrived is within the safety
+	// margin of its bitrate
+	uint32_t top = m_ladder.size () - 1;
+	uint8_t rateLevel = 0;
+	for (uint32_t i = 0; i <= top; i++)
+	{
+		if (GetBitrate (i) <= throughput / m_safety)
+			rateLevel = i;
+	}
+
+	uint32_t midFrames = (lowFrames + highFrames) / 2;
+	if (bufferedFrames <= lowFrames)
+	{
+		// draining into the reservoir: step down at least one level
+		uint8_t down = m_level > 0 ? m_level - 1 : 0;
+		m_level = std::min (rateLevel, down);
+	}
+	else if (bufferedFrames < midFrames)
+	{
+		// follow the link down, never up
+		m_level = std::min (rateLevel, m_level);
+	}
+	else if (m_level < top && throughput >= m_safety * GetBitrate (m_level))
+	{
+		// current level is fully delivered and the buffer is healthy: probe
+		m_level++;
+	}
+
+	return m_level;
+}
+
+}
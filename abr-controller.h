@@ -0,0 +1,50 @@
+#ifndef ABR_CONTROLLER_H
+#define ABR_CONTROLLER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+// Client-side quality selection over a ladder of packets-per-frame levels.
+// Hybrid rule: the buffer level decides whether to step down, hold or
+// probe upward, and the measured throughput caps how far down to go.
+class AbrController
+{
+public:
+	AbrController ();
+
+	// "25,50,75,100" -> {25, 50, 75, 100}, lowest quality first
+	static std::vector<uint32_t> ParseLadder (const std::string &levels);
+
+	// levels travel as uint8_t and 0xff means "no preference", so a
+	// ladder holds at most this many; callers reject longer ones
+	static const uint32_t MAX_LEVELS = 255;
+
+	void SetLadder (const std::vector<uint32_t> &ladder);
+	void SetStreamParameters (uint32_t packetSize, double fps);
+	void SetSafetyFactor (double safety);
+
+	bool IsEnabled (void) const;
+	uint32_t GetLevelCount (void) const;
+	uint8_t GetLevel (void) const;
+	uint32_t GetFramePackets (uint8_t level) const;
+	double GetBitrate (uint8_t level) const;
+
+	// Picks the level for the next interval. lowFrames/highFrames are the
+	// reservoir and cushion of the playout buffer, in frames.
+	uint8_t Update (double throughput, uint32_t bufferedFrames,
+	                uint32_t lowFrames, uint32_t highFrames);
+
+private:
+	std::vector<uint32_t> m_ladder;
+	uint8_t m_level;
+	uint32_t m_packetSize;
+	double m_fps;
+	double m_safety;
+};
+
+}
+
+#endif
@@ -8,6 +8,14 @@
 #include "streaming-helper.h"
 #include "streaming-streamer.h"
 #include "streaming-client.h"
+#include "qoe-collector.h"
+#include "gilbert-elliott-error-model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <vector>
 
 using namespace ns3;
 NS_LOG_COMPONENT_DEFINE ("assn3");
@@ -15,8 +23,6 @@ NS_LOG_COMPONENT_DEFINE ("assn3");
 int
 main (int argc, char *argv[])
 {
-	srand(time(NULL));
-
     // LogComponentEnable("StreamingStreamerApplication", (LogLevel)(LOG_LEVEL_INFO|LOG_PREFIX_TIME|LOG_PREFIX_NODE));
 	// LogComponentEnable("StreamingClientApplication", (LogLevel)(LOG_LEVEL_INFO|LOG_PREFIX_TIME|LOG_PREFIX_NODE));
 	LogComponentEnable("StreamingClientApplication", LOG_LEVEL_INFO);
@@ -29,12 +35,20 @@ main (int argc, char *argv[])
 	 * ========================
 	 */
 
-	// Forced Packet Error Generate
-	double errorRate = 2.0; // 0 ~ 100 % 	 default
+	// Forced Packet Error Generate: Gilbert-Elliott burst loss on every receiver
+	double errorRate = 2.0; // 0 ~ 100 % 	 default, mean loss rate
+	double burstLength = 1.0; // mean packets per loss burst
+	std::string lossLayer = "app"; // app: datagrams dropped at the sockets; phy: MPDUs dropped below MAC retries
 	bool packetLossEnable = true; // on/off, If want to loss rate 0, it must be false.
 
 	// Server Configuration
 	uint32_t sendFPS = 90; 
+	bool pacing = false; // spread each frame over the frame interval
+	std::string pacingRate = "0bps"; // 0: even spacing within the frame interval
+	double fecRatio = 0.0; // parity packets per data packet, 0: off
+	std::string qualityLevels = ""; // ABR ladder in packets per frame, e.g. "25,50,75,100"; empty: fixed
+	std::string rateControl = ""; // sender congestion control: aimd, gcc; empty: send at the credit limit
+	std::string frameTrace = ""; // frameNo,type,bytes or ASU video trace; empty: fixed framePackets frames
 
 	// Client Configuration
 	uint32_t bufferSize = 40;
@@ -42,6 +56,11 @@ main (int argc, char *argv[])
 	uint32_t resumeSize = 25;
 	double consumeStartTime = 1.0; // Seconds
 	uint32_t buffering = 15;  // default
+	bool adaptiveBuffering = false; // size buffering/pause/resume from measured conditions
+	bool adaptivePlayout = false; // stretch playout while the buffer is low, speed up while deep
+	uint32_t nStations = 1; // viewers served by the single streamer
+	bool multicast = false; // one group stream for all stations, NACK repair per receiver
+	std::string qoePrefix = ""; // writes <prefix>-<station>.csv, .json and -hist.csv QoE files; empty: off
 
 	/*
 	 * =======================
@@ -55,10 +74,50 @@ main (int argc, char *argv[])
 	double simulationTime = 60;
 	CommandLine cmd;
 
-	cmd.AddValue("error", "error rate", errorRate);
+	cmd.AddValue("error", "mean loss rate in percent: per datagram with lossLayer=app, per MPDU before MAC retries with lossLayer=phy", errorRate);
+	cmd.AddValue("burst", "mean loss burst length in packets", burstLength);
+	cmd.AddValue("lossLayer", "where the burst loss applies: app (seen by the apps) or phy (masked by MAC retries)", lossLayer);
+	cmd.AddValue("fps", "streaming frames per second", sendFPS);
+	cmd.AddValue("bufferSize", "client frame buffer size", bufferSize);
+	cmd.AddValue("pauseSize", "client credit window in frames", pauseSize);
+	cmd.AddValue("resumeSize", "client low buffer level for ABR", resumeSize);
+	cmd.AddValue("framePackets", "packets per frame", fpacketN);
+	cmd.AddValue("simTime", "simulation time in seconds", simulationTime);
 	cmd.AddValue("buffering", "buffering", buffering);
+	cmd.AddValue("adaptiveBuffering", "adapt buffer thresholds to network conditions", adaptiveBuffering);
+	cmd.AddValue("adaptivePlayout", "adapt the playout rate to the buffer level", adaptivePlayout);
+	cmd.AddValue("pacing", "pace streamer packets", pacing);
+	cmd.AddValue("pacingRate", "pacing rate (e.g. 200Mbps)", pacingRate);
+	cmd.AddValue("quality", "ABR quality ladder in packets per frame", qualityLevels);
+	cmd.AddValue("fec", "FEC parity packets per data packet", fecRatio);
+	cmd.AddValue("rateControl", "sender rate controller: aimd or gcc", rateControl);
+	cmd.AddValue("frameTrace", "per-frame type and size trace file", frameTrace);
+	cmd.AddValue("stations", "number of client stations", nStations);
+	cmd.AddValue("multicast", "stream to a multicast group instead of per-client unicast", multicast);
+	cmd.AddValue("qoe", "QoE output prefix for per-station time series and summaries", qoePrefix);
+	cmd.AddValue("tcp", "use the TCP transport with length-prefixed framing", tcp);
 	cmd.Parse(argc, argv);
 
+	if (tcp && multicast)
+	{
+		NS_FATAL_ERROR ("The TCP transport cannot stream to a multicast group");
+	}
+	if (lossLayer != "app" && lossLayer != "phy")
+	{
+		NS_FATAL_ERROR ("Unknown loss layer " << lossLayer);
+	}
+	if (tcp && lossLayer == "app")
+	{
+		// a byte stream has no datagrams to drop; TCP sees the loss the link leaves it
+		lossLayer = "phy";
+	}
+
+	if (nStations > 1)
+	{
+		// tell the viewers apart in the log
+		LogComponentEnable("StreamingClientApplication", (LogLevel)(LOG_LEVEL_INFO|LOG_PREFIX_NODE));
+	}
+
 	if (tcp)
 	{
 		payloadSize = 1448;
@@ -68,7 +127,7 @@ main (int argc, char *argv[])
 	uint32_t antenna = 3;
 	// Node Create
 	NodeContainer wifiStaNode;
-	wifiStaNode.Create (1);
+	wifiStaNode.Create (nStations);
 	NodeContainer wifiApNode;
 	wifiApNode.Create (1);
 
@@ -88,6 +147,11 @@ main (int argc, char *argv[])
 	wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager", 
 																"DataMode", StringValue ("VhtMcs9"),
 																"ControlMode", StringValue ("VhtMcs0"));
+	if (multicast)
+	{
+		// group frames are not acknowledged; send them at the data rate instead of the basic rate
+		Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue ("VhtMcs9"));
+	}
 	// Mac Setting
 	WifiMacHelper mac;
 	Ssid ssid = Ssid ("assn3");
@@ -105,12 +169,38 @@ main (int argc, char *argv[])
 	NetDeviceContainer apDevice;
 	apDevice = wifi.Install (phy, mac, wifiApNode);
 
+	// Error Model: stations lose downlink frames, the AP loses uplink reports
+	bool burstLoss = packetLossEnable && errorRate > 0;
+	// loss rate = burst / (burst + gap)
+	double gapLength = burstLoss ? std::max (1.0, burstLength * (100 - errorRate) / errorRate) : 0;
+	int64_t stream = 1000; // fixed streams keep the loss pattern stable across topology changes
+	if (burstLoss && lossLayer == "phy")
+	{
+		// below the MAC, unicast retries and BlockAck repair most of this loss
+		NetDeviceContainer devices;
+		devices.Add (staDevice);
+		devices.Add (apDevice);
+		for (uint32_t i = 0; i < devices.GetN (); i++)
+		{
+			Ptr<GilbertElliottErrorModel> em = CreateObject<GilbertElliottErrorModel> ();
+			em->SetAttribute ("MeanBurstLength", DoubleValue (burstLength));
+			em->SetAttribute ("MeanGapLength", DoubleValue (gapLength));
+			stream += em->AssignStreams (stream);
+			DynamicCast<WifiNetDevice> (devices.Get (i))->GetPhy ()->SetPostReceptionErrorModel (em);
+		}
+	}
+
 	// Mobility Setting 
 	MobilityHelper mobility;
 	Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator> ();
 
 	positionAlloc->Add (Vector (0.0, 0.0, 0.0));
-	positionAlloc->Add (Vector (1.0, 0.0, 0.0));
+	for (uint32_t i = 0; i < nStations; i++)
+	{
+		// stations on a 1 m circle around the AP
+		double angle = 2 * M_PI * i / nStations;
+		positionAlloc->Add (Vector (std::cos (angle), std::sin (angle), 0.0));
+	}
 	mobility.SetPositionAllocator (positionAlloc);
 
 	mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
@@ -131,13 +221,35 @@ main (int argc, char *argv[])
 	staNodeInterface = address.Assign (staDevice);
 	apNodeInterface = address.Assign (apDevice);
 
+	Ipv4Address multicastGroup ("225.1.2.4");
+	if (multicast)
+	{
+		Ipv4StaticRoutingHelper multicastRouting;
+		multicastRouting.SetDefaultMulticastRoute (wifiApNode.Get (0), apDevice.Get (0));
+	}
+
 	// Application Stack Install
-	StreamingStreamerHelper streamer ( staNodeInterface.GetAddress(0), 9);
+	// clients join the streamer by sending feedback to its local port
+	StreamingStreamerHelper streamer (Address (), 9);
+	streamer.SetAttribute ("LocalPort", UintegerValue (49153));
 	streamer.SetAttribute ("PacketSize", UintegerValue (payloadSize));
 	streamer.SetAttribute ("FramePackets", UintegerValue (fpacketN));
 	streamer.SetAttribute ("StreamingFPS", UintegerValue (sendFPS));
-	streamer.SetAttribute ("PacketLossEnable", BooleanValue (packetLossEnable));
-	streamer.SetAttribute ("ErrorRate", DoubleValue (errorRate / 100));
+	streamer.SetAttribute ("PacingEnable", BooleanValue (pacing));
+	streamer.SetAttribute ("PacingRate", DataRateValue (DataRate (pacingRate)));
+	streamer.SetAttribute ("QualityLevels", StringValue (qualityLevels));
+	streamer.SetAttribute ("FecRatio", DoubleValue (fecRatio));
+	streamer.SetAttribute ("FrameTrace", StringValue (frameTrace));
+	if (rateControl == "aimd")
+		streamer.SetAttribute ("RateController", StringValue ("ns3::AimdRateController"));
+	else if (rateControl == "gcc")
+		streamer.SetAttribute ("RateController", StringValue ("ns3::GccRateController"));
+	else if (!rateControl.empty ())
+		NS_FATAL_ERROR ("Unknown rate controller " << rateControl);
+	if (multicast)
+		streamer.SetAttribute ("MulticastGroup", AddressValue (multicastGroup));
+	if (tcp)
+		streamer.SetAttribute ("Protocol", TypeIdValue (TcpSocketFactory::GetTypeId ()));
 	ApplicationContainer streamerApp = streamer.Install (wifiApNode.Get (0));
 	streamerApp.Start (Seconds (1.0));
 	streamerApp.Stop (Seconds (simulationTime));
@@ -149,16 +261,67 @@ main (int argc, char *argv[])
 	client.SetAttribute ("PauseSize", UintegerValue (pauseSize));
 	client.SetAttribute ("ResumeSize", UintegerValue (resumeSize));
 	client.SetAttribute ("ConsumeStartTime", DoubleValue (consumeStartTime));
-	client.SetAttribute ("PacketLossEnable", BooleanValue (packetLossEnable));
-	client.SetAttribute ("ErrorRate", DoubleValue (errorRate / 100));
 	client.SetAttribute ("Buffering", UintegerValue (buffering));
-	ApplicationContainer clientApp = client.Install (wifiStaNode.Get (0));
+	client.SetAttribute ("AdaptivePlayout", BooleanValue (adaptivePlayout));
+	client.SetAttribute ("AdaptiveBuffering", BooleanValue (adaptiveBuffering));
+	if (!rateControl.empty ())
+	{
+		// delay-trend estimation needs reports more often than the keepalive
+		client.SetAttribute ("ReportInterval", TimeValue (MilliSeconds (100)));
+	}
+	client.SetAttribute ("QualityLevels", StringValue (qualityLevels));
+	client.SetAttribute ("StreamingFPS", DoubleValue (sendFPS));
+	if (multicast)
+		client.SetAttribute ("MulticastGroup", AddressValue (multicastGroup));
+	if (tcp)
+		client.SetAttribute ("Protocol", TypeIdValue (TcpSocketFactory::GetTypeId ()));
+	ApplicationContainer clientApp;
+	for (uint32_t i = 0; i < nStations; i++)
+	{
+		clientApp.Add (client.Install (wifiStaNode.Get (i)));
+	}
 	clientApp.Start (Seconds (0.0));
 	clientApp.Stop (Seconds (simulationTime));
 
+	if (burstLoss && lossLayer == "app")
+	{
+		// the same per-receiver models as on the PHY, applied to the datagrams the apps get
+		ApplicationContainer apps;
+		apps.Add (clientApp);
+		apps.Add (streamerApp);
+		for (uint32_t i = 0; i < apps.GetN (); i++)
+		{
+			Ptr<GilbertElliottErrorModel> em = CreateObject<GilbertElliottErrorModel> ();
+			em->SetAttribute ("MeanBurstLength", DoubleValue (burstLength));
+			em->SetAttribute ("MeanGapLength", DoubleValue (gapLength));
+			stream += em->AssignStreams (stream);
+			apps.Get (i)->SetAttribute ("ReceiveErrorModel", PointerValue (em));
+		}
+	}
+
+	std::vector<QoeCollector> qoe (qoePrefix.empty () ? 0 : nStations);
+	for (uint32_t i = 0; i < qoe.size (); i++)
+	{
+		std::ostringstream name;
+		name << qoePrefix << "-" << i;
+		qoe[i].Attach (DynamicCast<StreamingClient> (clientApp.Get (i)));
+		qoe[i].EnableTimeSeries (name.str () + ".csv", Seconds (0.5));
+	}
+
 	// Simulation Start
 	Simulator::Stop (Seconds (simulationTime));
+	std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now ();
 	Simulator::Run ();
+	double wallTime = std::chrono::duration<double> (std::chrono::steady_clock::now () - wallStart).count ();
+	std::cout << "assn3: " << nStations << " stations, " << wallTime << " s wall clock, "
+		<< Simulator::GetEventCount () << " events" << std::endl;
+	for (uint32_t i = 0; i < qoe.size (); i++)
+	{
+		std::ostringstream name;
+		name << qoePrefix << "-" << i;
+		qoe[i].WriteSummary (name.str () + ".json");
+		qoe[i].WriteHistogram (name.str () + "-hist.csv");
+	}
 	Simulator::Destroy ();
 
 	return 0;
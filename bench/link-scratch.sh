@@ -0,0 +1,23 @@
+#!/bin/sh
+# Sets up the microbenchmark as its own ns-3 scratch program.
+#
+# waf builds every .cc in a scratch subdirectory into one program, so the
+# benchmark gets a directory of its own that links to the streaming sources
+# (everything but assn3.cc, which has its own main).
+#
+#   bench/link-scratch.sh <ns-3 dir>
+#   cd <ns-3 dir> && ./waf --run "streaming-bench --framePackets=100"
+set -e
+
+ns3=${1:?usage: $0 <ns-3 dir>}
+src=$(cd "$(dirname "$0")/.." && pwd)
+dst="$ns3/scratch/streaming-bench"
+
+mkdir -p "$dst"
+for f in "$src"/*.h "$src"/*.cc "$src"/bench/streaming-bench.cc; do
+	case "$(basename "$f")" in
+		assn3.cc) continue ;;
+	esac
+	ln -sf "$f" "$dst/$(basename "$f")"
+done
+echo "linked $(ls "$dst" | wc -l) files into $dst"
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""End-to-end performance gate for the assn3 scenario.
+
+Runs a fixed matrix of scenarios (stations x error rates), records wall
+clock, simulator events per second, peak RSS and the QoE summary of each,
+and compares them with a stored baseline. Exits non-zero when a scenario
+got slower or bigger than the baseline by more than the threshold.
+
+    # once, on the reference build
+    python3 bench/perf-gate.py --ns3-dir ~/ns-3 --update-baseline
+    # on every change
+    python3 bench/perf-gate.py --ns3-dir ~/ns-3
+
+Each scenario runs --repeat times and the fastest run counts, which
+filters out most scheduler noise. The gate is only meaningful against a
+baseline recorded on the same machine with the same build profile.
+"""
+
+import argparse
+import glob
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+sys.path.insert (0, os.path.join (os.path.dirname (os.path.abspath (__file__)), ".."))
+from sweep import find_binary, SUMMARY_LINE  # noqa: E402
+
+QOE_KEYS = ["startup_delay", "stall_count", "stall_time", "frames_skipped", "average_bitrate"]
+
+
+def run_scenario (binary, env, workdir, stations, error, sim_time, extra):
+    args = [binary, "--stations=%d" % stations, "--error=%g" % error,
+            "--simTime=%g" % sim_time, "--RngRun=1", "--qoe=qoe"] + extra
+    os.makedirs (workdir, exist_ok=True)
+    for old in glob.glob (os.path.join (workdir, "qoe-*")):
+        os.remove (old)
+
+    start = time.time ()
+    proc = subprocess.Popen (args, cwd=workdir, env=env, stdout=subprocess.PIPE,
+                             stderr=subprocess.DEVNULL, universal_newlines=True)
+    stdout = proc.stdout.read ()
+    # wait4 gives this child's own rusage, so peak RSS is per run
+    _, status, usage = os.wait4 (proc.pid, 0)
+    wall = time.time () - start
+    proc.returncode = os.waitstatus_to_exitcode (status) if hasattr (os, "waitstatus_to_exitcode") else status
+    if proc.returncode != 0:
+        raise RuntimeError ("scenario failed: " + " ".join (args))
+
+    result = {"wall_clock": wall, "peak_rss_kb": usage.ru_maxrss}
+    match = SUMMARY_LINE.search (stdout)
+    if match:
+        # the scenario's own timer excludes process start-up and topology setup
+        result["run_time"] = float (match.group (2))
+        result["events"] = int (match.group (3))
+        result["events_per_s"] = result["events"] / max (result["run_time"], 1e-9)
+
+    summaries = []
+    for path in sorted (glob.glob (os.path.join (workdir, "qoe-*.json"))):
+        with open (path) as f:
+            summaries.append (json.load (f))
+    for key in QOE_KEYS:
+        values = [s[key] for s in summaries if key in s]
+        if values:
+            result[key] = sum (values) / len (values)
+    return result
+
+
+def compare (name, current, baseline, threshold):
+    """Returns a list of regression messages for one scenario."""
+    failures = []
+    # lower is better
+    for key in ("run_time", "peak_rss_kb"):
+        if key in current and baseline.get (key):
+            change = current[key] / baseline[key] - 1
+            if change > threshold:
+                failures.append ("%s: %s %.3g -> %.3g (%+.1f%%)" % (name, key, baseline[key],
+                                                                  current[key], 100 * change))
+    # higher is better
+    key = "events_per_s"
+    if key in current and baseline.get (key):
+        change = current[key] / baseline[key] - 1
+        if change < -threshold:
+            failures.append ("%s: %s %.3g -> %.3g (%+.1f%%)" % (name, key, baseline[key],
+                                                              current[key], 100 * change))
+    return failures
+
+
+def main ():
+    parser = argparse.ArgumentParser (description=__doc__,
+                                      formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument ("--ns3-dir", default=".", help="ns-3 top-level directory")
+    parser.add_argument ("--program", default="assn3", help="scratch program name")
+    parser.add_argument ("--binary", help="built scenario binary (default: search build/scratch)")
+    parser.add_argument ("--stations", default="1,8,32", help="station counts, comma separated")
+    parser.add_argument ("--error", default="0,2,5", help="error rates in percent, comma separated")
+    parser.add_argument ("--sim-time", type=float, default=60, help="simulated seconds per scenario")
+    parser.add_argument ("--repeat", type=int, default=3, help="runs per scenario; the fastest counts")
+    parser.add_argument ("--threshold", type=float, default=0.10,
+                         help="allowed relative regression, e.g. 0.10 for 10%%")
+    parser.add_argument ("--baseline", default=os.path.join (os.path.dirname (os.path.abspath (__file__)),
+                                                             "perf-baseline.json"))
+    parser.add_argument ("--update-baseline", action="store_true",
+                         help="record this run as the new baseline instead of comparing")
+    parser.add_argument ("--out", help="also write this run's results to a JSON file")
+    parser.add_argument ("extra", nargs="*", help="further arguments passed to every scenario")
+    opts = parser.parse_args ()
+
+    binary = opts.binary or find_binary (opts.ns3_dir, opts.program)
+    if not binary:
+        sys.exit ("cannot find the %s binary under %s/build; build it first or pass --binary"
+                  % (opts.program, opts.ns3_dir))
+    env = dict (os.environ)
+    libdirs = [os.path.abspath (os.path.join (opts.ns3_dir, "build", "lib")),
+               os.path.abspath (os.path.join (opts.ns3_dir, "build"))]
+    env["LD_LIBRARY_PATH"] = os.pathsep.join (libdirs + [env.get ("LD_LIBRARY_PATH", "")])
+
+    workdir = tempfile.mkdtemp (prefix="assn3-perf-")
+    results = {}
+    for stations in [int (s) for s in opts.stations.split (",") if s]:
+        for error in [float (e) for e in opts.error.split (",") if e]:
+            name = "stations=%d,error=%g" % (stations, error)
+            runs = [run_scenario (binary, env, os.path.join (workdir, name), stations, error,
+                                  opts.sim_time, opts.extra) for _ in range (opts.repeat)]
+            best = min (runs, key=lambda r: r.get ("run_time", r["wall_clock"]))
+            best["peak_rss_kb"] = max (r["peak_rss_kb"] for r in runs)
+            results[name] = best
+            print ("%-24s %8.2f s %12.0f events/s %8d KB  stalls %.1f"
+                   % (name, best.get ("run_time", best["wall_clock"]), best.get ("events_per_s", 0),
+                      best["peak_rss_kb"], best.get ("stall_count", 0)))
+
+    record = {"sim_time": opts.sim_time, "binary": binary, "scenarios": results}
+    if opts.out:
+        with open (opts.out, "w") as f:
+            json.dump (record, f, indent=2, sort_keys=True)
+
+    if opts.update_baseline:
+        with open (opts.baseline, "w") as f:
+            json.dump (record, f, indent=2, sort_keys=True)
+        print ("baseline written to %s" % opts.baseline)
+        return 0
+
+    if not os.path.exists (opts.baseline):
+        sys.exit ("no baseline at %s; record one with --update-baseline" % opts.baseline)
+    with open (opts.baseline) as f:
+        baseline = json.load (f)
+    if baseline.get ("sim_time") != opts.sim_time:
+        sys.exit ("baseline was recorded with --sim-time %s" % baseline.get ("sim_time"))
+
+    failures = []
+    for name, current in sorted (results.items ()):
+        if name not in baseline["scenarios"]:
+            print ("%s: not in baseline, skipped" % name)
+            continue
+        base = baseline["scenarios"][name]
+        failures += compare (name, current, base, opts.threshold)
+        # QoE drift is reported, not failed: behaviour changes are often intended
+        for key in QOE_KEYS:
+            if key in current and key in base and current[key] != base[key]:
+                print ("%s: %s %.4g -> %.4g" % (name, key, base[key], current[key]))
+
+    for line in failures:
+        print ("REGRESSION " + line)
+    print ("%d scenarios, %d regressions beyond %.0f%%" % (len (results), len (failures),
+                                                          100 * opts.threshold))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit (main ())
@@ -0,0 +1,356 @@
+// Microbenchmarks for the client and streamer hot paths.
+//
+// Each case replays a synthetic stream of frames through one data
+// structure under a loss pattern and reports ns per operation. Loss masks
+// are generated up front, so RNG cost is not measured.
+//
+//   header   ClientHeader Serialize + Deserialize of a full NACK report
+//   receive  sequence tracking + frame window update per received packet,
+//            mirroring the data path of StreamingClient::HandleRead
+//   frame    FrameCheck Mark / IsComplete / FEC Recover per packet
+//   rexmit   RetransmitScheduler Enqueue / DropBelow / Dequeue per loss,
+//            as driven by StreamingStreamer::SendFrame and HandleRead
+//
+// The benchmark links against the streaming sources; see link-scratch.sh.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include "client-header.h"
+#include "frame-window.h"
+#include "sequence-range-set.h"
+#include "retransmit-scheduler.h"
+#include "streaming-client.h"
+
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+volatile uint64_t g_sink;
+
+struct LossPattern
+{
+	std::string name;
+	double rate;
+	double burst; // mean burst length; 1 is independent loss
+};
+
+struct Arrival
+{
+	uint32_t seq;
+	uint32_t frameIdx;
+	uint32_t packetIdx;
+};
+
+// Gilbert-Elliott mask with mean loss rate and burst length; burst 1 is Bernoulli.
+std::vector<bool>
+MakeLossMask (const LossPattern &pattern, uint32_t packets, uint32_t seed)
+{
+	std::mt19937 gen (seed);
+	std::uniform_real_distribution<double> uniform (0.0, 1.0);
+	std::vector<bool> lost (packets, false);
+	if (pattern.rate <= 0)
+		return lost;
+
+	if (pattern.burst <= 1)
+	{
+		for (uint32_t i = 0; i < packets; i++)
+			lost[i] = uniform (gen) < pattern.rate;
+		return lost;
+	}
+
+	double gap = pattern.burst * (1 - pattern.rate) / pattern.rate;
+	bool bad = false;
+	for (uint32_t i = 0; i < packets; i++)
+	{
+		if (uniform (gen) < 1.0 / (bad ? pattern.burst : gap))
+			bad = !bad;
+		lost[i] = bad;
+	}
+	return lost;
+}
+
+// Arrival order at the client: every packet not lost, plus each lost packet
+// again as a retransmission `delay` frames later.
+std::vector<Arrival>
+MakeArrivals (const std::vector<bool> &lost, uint32_t framePackets, uint32_t delay)
+{
+	std::vector<Arrival> arrivals;
+	std::deque<std::pair<uint32_t, Arrival> > repairs;
+	uint32_t frames = lost.size () / framePackets;
+	for (uint32_t f = 0; f < frames; f++)
+	{
+		while (!repairs.empty () && repairs.front ().first <= f)
+		{
+			arrivals.push_back (repairs.front ().second);
+			repairs.pop_front ();
+		}
+		for (uint32_t p = 0; p < framePackets; p++)
+		{
+			Arrival a;
+			a.seq = f * framePackets + p;
+			a.frameIdx = f;
+			a.packetIdx = p;
+			if (lost[a.seq])
+				repairs.push_back (std::make_pair (f + delay, a));
+			else
+				arrivals.push_back (a);
+		}
+	}
+	return arrivals;
+}
+
+// Runs body until minTime has passed and returns ns per operation.
+template <typename F>
+double
+Measure (F body, uint64_t opsPerCall, double minTime)
+{
+	body (); // warm up
+	uint64_t calls = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+	double elapsed = 0;
+	do
+	{
+		body ();
+		calls++;
+		elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+	}
+	while (elapsed < minTime);
+	return elapsed * 1e9 / (calls * std::max<uint64_t> (opsPerCall, 1));
+}
+
+double
+BenchHeader (const std::vector<bool> &lost, double minTime)
+{
+	ClientHeader header;
+	header.SetPlayoutFrame (1234);
+	header.SetCredits (30);
+	uint32_t i = 0;
+	while (i < lost.size () && header.GetNackRangeCount () < ClientHeader::MAX_NACK_RANGES)
+	{
+		if (!lost[i])
+		{
+			i++;
+			continue;
+		}
+		uint32_t start = i;
+		while (i < lost.size () && lost[i])
+			i++;
+		header.AddNackRange (start, i - start);
+	}
+
+	Buffer buffer;
+	buffer.AddAtStart (header.GetSerializedSize ());
+	return Measure ([&] () {
+		header.Serialize (buffer.Begin ());
+		ClientHeader out;
+		out.Deserialize (buffer.Begin ());
+		g_sink += out.GetNackRangeCount ();
+	}, 1, minTime);
+}
+
+double
+BenchReceive (const std::vector<Arrival> &arrivals, uint32_t framePackets, double minTime)
+{
+	const uint32_t buffer = 40;
+	return Measure ([&] () {
+		SequenceRangeSet losses;
+		FrameWindow<FrameCheck> frames;
+		frames.SetCapacity (buffer * 2);
+		uint32_t nextSeq = 0;
+		uint32_t newest = 0;
+		uint32_t completed = 0;
+		for (uint32_t i = 0; i < arrivals.size (); i++)
+		{
+			const Arrival &a = arrivals[i];
+			if (a.frameIdx > newest)
+			{
+				// playout trails the newest frame by the buffer depth
+				newest = a.frameIdx;
+				if (newest > buffer)
+				{
+					frames.Advance (newest - buffer);
+					losses.RemoveBelow ((newest - buffer) * framePackets);
+				}
+			}
+			if (!frames.InWindow (a.frameIdx))
+				continue;
+
+			if (nextSeq == a.seq)
+				nextSeq++;
+			else if (nextSeq < a.seq)
+			{
+				losses.AddRange (nextSeq, a.seq);
+				nextSeq = a.seq + 1;
+			}
+			else
+				losses.Remove (a.seq);
+
+			FrameCheck *check = frames.Find (a.frameIdx);
+			if (check == 0)
+			{
+				check = frames.Insert (a.frameIdx);
+				check->Reset (framePackets, a.seq - a.packetIdx, 0);
+			}
+			check->Mark (a.packetIdx);
+			if (check->IsComplete ())
+			{
+				frames.Erase (a.frameIdx);
+				completed++;
+			}
+		}
+		g_sink += completed + losses.GetCount ();
+	}, arrivals.size (), minTime);
+}
+
+double
+BenchFrameCheck (const std::vector<bool> &lost, uint32_t framePackets, double minTime)
+{
+	const uint32_t fecGroup = 10;
+	uint32_t frames = lost.size () / framePackets;
+	return Measure ([&] () {
+		FrameCheck check;
+		uint32_t recovered = 0;
+		for (uint32_t f = 0; f < frames; f++)
+		{
+			check.Reset (framePackets, f * framePackets, fecGroup);
+			for (uint32_t p = 0; p < framePackets; p++)
+			{
+				if (!lost[f * framePackets + p])
+					check.Mark (p);
+			}
+			for (uint32_t g = 0; g * fecGroup < framePackets; g++)
+			{
+				check.MarkParity (g);
+				uint32_t missing = check.Recover (g);
+				if (missing < framePackets)
+				{
+					check.Mark (missing);
+					recovered++;
+				}
+			}
+			recovered += check.IsComplete ();
+		}
+		g_sink += recovered;
+	}, lost.size (), minTime);
+}
+
+double
+BenchRetransmit (const std::vector<bool> &lost, uint32_t framePackets, double minTime)
+{
+	uint32_t frames = lost.size () / framePackets;
+	uint64_t losses = 0;
+	for (uint32_t i = 0; i < lost.size (); i++)
+		losses += lost[i];
+
+	return Measure ([&] () {
+		RetransmitScheduler scheduler;
+		scheduler.SetHoldOff (MilliSeconds (50));
+		uint64_t sent = 0;
+		for (uint32_t f = 0; f < frames; f++)
+		{
+			Time now = MicroSeconds (f * 11111); // 90 fps
+			// every loss of the last three frames is NACKed again each tick
+			uint32_t first = f >= 2 ? (f - 2) * framePackets : 0;
+			for (uint32_t seq = first; seq < (f + 1) * framePackets; seq++)
+			{
+				if (lost[seq])
+					scheduler.Enqueue (seq, now);
+			}
+			scheduler.DropBelow (first);
+			uint32_t seq;
+			for (uint32_t n = 0; n < 100 && scheduler.Dequeue (seq, now); n++)
+				sent++;
+		}
+		g_sink += sent;
+	}, losses, minTime);
+}
+
+std::vector<uint32_t>
+ParseList (const std::string &text)
+{
+	std::vector<uint32_t> values;
+	std::stringstream ss (text);
+	std::string item;
+	while (std::getline (ss, item, ','))
+	{
+		if (!item.empty ())
+			values.push_back (std::strtoul (item.c_str (), 0, 10));
+	}
+	return values;
+}
+
+}
+
+int
+main (int argc, char *argv[])
+{
+	double minTime = 0.2;
+	std::string framePackets = "25,100,400";
+	std::string filter = "";
+	std::string csv = "";
+	uint32_t frames = 900;
+
+	CommandLine cmd;
+	cmd.AddValue("minTime", "minimum seconds per measurement", minTime);
+	cmd.AddValue("framePackets", "packets per frame, comma separated", framePackets);
+	cmd.AddValue("frames", "frames per replayed stream", frames);
+	cmd.AddValue("filter", "only run cases whose name contains this", filter);
+	cmd.AddValue("csv", "also write the results to this CSV file", csv);
+	cmd.Parse(argc, argv);
+
+	std::vector<LossPattern> patterns = {
+		{"none", 0.0, 1}, {"random-0.1%", 0.001, 1}, {"random-1%", 0.01, 1},
+		{"random-5%", 0.05, 1}, {"random-20%", 0.2, 1},
+		{"burst8-1%", 0.01, 8}, {"burst8-5%", 0.05, 8}, {"burst32-20%", 0.2, 32}};
+
+	std::ofstream out;
+	if (!csv.empty ())
+	{
+		out.open (csv.c_str ());
+		out << "case,pattern,frame_packets,ns_per_op" << std::endl;
+	}
+	std::cout << std::left << std::setw (10) << "case" << std::setw (14) << "pattern"
+		<< std::setw (8) << "fpkts" << "ns/op" << std::endl;
+
+	std::vector<uint32_t> sizes = ParseList (framePackets);
+	for (uint32_t s = 0; s < sizes.size (); s++)
+	{
+		for (uint32_t p = 0; p < patterns.size (); p++)
+		{
+			const LossPattern &pattern = patterns[p];
+			std::vector<bool> lost = MakeLossMask (pattern, frames * sizes[s], 1 + p);
+			std::vector<Arrival> arrivals = MakeArrivals (lost, sizes[s], 3);
+
+			std::vector<std::pair<std::string, double> > results;
+			if (filter.empty () || std::string ("header").find (filter) != std::string::npos)
+				results.push_back (std::make_pair ("header", BenchHeader (lost, minTime)));
+			if (filter.empty () || std::string ("receive").find (filter) != std::string::npos)
+				results.push_back (std::make_pair ("receive", BenchReceive (arrivals, sizes[s], minTime)));
+			if (filter.empty () || std::string ("frame").find (filter) != std::string::npos)
+				results.push_back (std::make_pair ("frame", BenchFrameCheck (lost, sizes[s], minTime)));
+			if ((filter.empty () || std::string ("rexmit").find (filter) != std::string::npos) && pattern.rate > 0)
+				results.push_back (std::make_pair ("rexmit", BenchRetransmit (lost, sizes[s], minTime)));
+
+			for (uint32_t r = 0; r < results.size (); r++)
+			{
+				std::cout << std::left << std::setw (10) << results[r].first << std::setw (14) << pattern.name
+					<< std::setw (8) << sizes[s] << std::fixed << std::setprecision (1) << results[r].second << std::endl;
+				if (out.is_open ())
+					out << results[r].first << "," << pattern.name << "," << sizes[s] << "," << results[r].second << std::endl;
+			}
+		}
+	}
+
+	return 0;
+}
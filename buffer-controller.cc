@@ -0,0 +1,166 @@
+#include "buffer-controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+BufferController::BufferController ()
+	: m_minFrames (3),
+	  m_maxFrames (40),
+	  m_fps (60),
+	  m_stallTarget (0.01),
+	  m_repairInterval (0.05),
+	  m_creditStep (0),
+	  m_rateMean (0),
+	  m_rateVar (0),
+	  m_haveRate (false),
+	  m_spread (0),
+	  m_burstFrames (0),
+	  m_intervalBurst (0),
+	  m_ticks (0),
+	  m_stalledTicks (0),
+	  m_safety (1),
+	  m_low (3),
+	  m_startup (5),
+	  m_credit (6)
+{
+}
+
+void
+BufferController::SetLimits (uint32_t minFrames, uint32_t maxFrames)
+{
+	m_minFrames = std::max<uint32_t> (1, minFrames);
+	m_maxFrames = std::max (m_minFrames, maxFrames);
+}
+
+void
+BufferController::SetPlayoutRate (double fps)
+{
+	m_fps = fps;
+}
+
+void
+BufferController::SetStallTarget (double ratio)
+{
+	m_stallTarget = ratio;
+}
+
+void
+BufferController::SetRepairInterval (double seconds)
+{
+	m_repairInterval = seconds;
+}
+
+void
+BufferController::SetCreditStep (uint32_t frames)
+{
+	m_creditStep = frames;
+}
+
+void
+BufferController::AddThroughput (double bps)
+{
+	const double alpha = 0.2;
+	if (!m_haveRate)
+	{
+		m_rateMean = bps;
+		m_rateVar = 0;
+		m_haveRate = true;
+		return;
+	}
+	double diff = bps - m_rateMean;
+	m_rateMean += alpha * diff;
+	m_rateVar = (1 - alpha) * (m_rateVar + alpha * diff * diff);
+}
+
+void
+BufferController::AddFrameSpread (double seconds)
+{
+	m_spread += (seconds - m_spread) / 8;
+}
+
+void
+BufferController::AddLossBurst (uint32_t packets, uint32_t framePackets)
+{
+	// a burst stalls every frame it touches until the repair arrives
+	uint32_t frames = (packets + std::max<uint32_t> (framePackets, 1) - 1) / std::max<uint32_t> (framePackets, 1);
+	m_intervalBurst = std::max (m_intervalBurst, frames);
+}
+
+void
+BufferController::AddPlayoutTick (bool stalled)
+{
+	m_ticks++;
+	if (stalled)
+		m_stalledTicks++;
+}
+
+void
+BufferController::Update (double delay, double jitter)
+{
+	if (m_ticks > 0)
+	{
+		double stallRatio = (double)m_stalledTicks / m_ticks;
+		if (stallRatio > m_stallTarget)
+			m_safety = std::min (8.0, m_safety * 1.5);
+		else
+			m_safety = std::max (1.0, m_safety * 0.95);
+	}
+	m_ticks = 0;
+	m_stalledTicks = 0;
+
+	// recent bursts count in full, older ones fade out
+	m_burstFrames = std::max<double> (m_intervalBurst, m_burstFrames * 0.8);
+	m_intervalBurst = 0;
+
+	double cv = 0;
+	if (m_haveRate && m_rateMean > 0)
+		cv = std::min (1.0, std::sqrt (m_rateVar) / m_rateMean);
+
+	double repair = 0;
+	if (m_burstFrames >= 0.1)
+		repair = m_repairInterval + 2 * delay + m_burstFrames / m_fps;
+
+	double cushion = m_spread + m_safety * jitter + repair;
+	m_low = Clamp (cushion * m_fps * (1 + m_safety * cv));
+	m_startup = Clamp (m_low * 1.5);
+	// the window only moves in m_creditStep jumps, so it needs that much
+	// on top of the startup level to never run dry between updates
+	m_credit = Clamp (std::max<double> (m_startup + m_creditStep, 2.0 * m_low));
+}
+
+uint32_t
+BufferController::Clamp (double frames) const
+{
+	double value = std::ceil (frames);
+	value = std::max<double> (value, m_minFrames);
+	value = std::min<double> (value, m_maxFrames);
+	return value;
+}
+
+uint32_t
+BufferController::GetLowFrames (void) const
+{
+	return m_low;
+}
+
+uint32_t
+BufferController::GetStartupFrames (void) const
+{
+	return m_startup;
+}
+
+uint32_t
+BufferController::GetCreditFrames (void) const
+{
+	return m_credit;
+}
+
+double
+BufferController::GetSafety (void) const
+{
+	return m_safety;
+}
+
+}
@@ -0,0 +1,74 @@
+#ifndef BUFFER_CONTROLLER_H
+#define BUFFER_CONTROLLER_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+// Client-side playout buffer sizing from measured network conditions.
+// The low watermark covers one frame's packet spread, the delay jitter
+// and the time to repair the recent loss bursts, stretched by the
+// throughput's coefficient of variation. The safety factor applied to
+// jitter and variance grows when the stall ratio misses its target and
+// slowly decays while it is met, so thresholds only stay large on links
+// that need them. Startup and credit thresholds follow the low mark; the
+// credit also covers the client's update step, so the streamer keeps
+// usable credit between two credit updates.
+class BufferController
+{
+public:
+	BufferController ();
+
+	// thresholds are kept within [minFrames, maxFrames]
+	void SetLimits (uint32_t minFrames, uint32_t maxFrames);
+	void SetPlayoutRate (double fps);
+	// fraction of playout ticks allowed to stall
+	void SetStallTarget (double ratio);
+	// time a lost packet waits before it is NACKed
+	void SetRepairInterval (double seconds);
+	// frames the credit limit advances before the client re-advertises it
+	void SetCreditStep (uint32_t frames);
+
+	void AddThroughput (double bps);
+	void AddFrameSpread (double seconds);
+	void AddLossBurst (uint32_t packets, uint32_t framePackets);
+	void AddPlayoutTick (bool stalled);
+
+	// recomputes the thresholds from what was added since the last call;
+	// delay and jitter are the client's current estimates in seconds
+	void Update (double delay, double jitter);
+
+	uint32_t GetLowFrames (void) const;
+	uint32_t GetStartupFrames (void) const;
+	uint32_t GetCreditFrames (void) const;
+	double GetSafety (void) const;
+
+private:
+	uint32_t Clamp (double frames) const;
+
+	uint32_t m_minFrames;
+	uint32_t m_maxFrames;
+	double m_fps;
+	double m_stallTarget;
+	double m_repairInterval;
+	uint32_t m_creditStep;
+
+	// exponentially weighted estimates
+	double m_rateMean;
+	double m_rateVar;
+	bool m_haveRate;
+	double m_spread;
+	double m_burstFrames;
+	uint32_t m_intervalBurst;
+	uint64_t m_ticks;
+	uint64_t m_stalledTicks;
+	double m_safety;
+
+	uint32_t m_low;
+	uint32_t m_startup;
+	uint32_t m_credit;
+};
+
+}
+
+#endif
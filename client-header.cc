@@ -1,12 +1,67 @@
 #include "ns3/ptr.h"
 #include "ns3/packet.h"
 #include "ns3/header.h"
+#include "ns3/assert.h"
 #include "client-header.h"
 #include <iostream>
 
 using namespace ns3;
 
+namespace {
+
+// LEB128-style variable-length integer, 7 bits per byte
+uint32_t
+VarIntSize (uint32_t value)
+{
+  uint32_t size = 1;
+  while (value >= 0x80)
+    {
+      value >>= 7;
+      size++;
+    }
+  return size;
+}
+
+void
+WriteVarInt (Buffer::Iterator &i, uint32_t value)
+{
+  while (value >= 0x80)
+    {
+      i.WriteU8 ((uint8_t)(value & 0x7f) | 0x80);
+      value >>= 7;
+    }
+  i.WriteU8 ((uint8_t)value);
+}
+
+uint32_t
+ReadVarInt (Buffer::Iterator &i)
+{
+  uint32_t value = 0;
+  uint32_t shift = 0;
+  uint8_t byte;
+  do
+    {
+      byte = i.ReadU8 ();
+      value |= (uint32_t)(byte & 0x7f) << shift;
+      shift += 7;
+    }
+  while ((byte & 0x80) && shift < 35);
+  return value;
+}
+
+}
+
 ClientHeader::ClientHeader ()
+  : flags (0),
+    playoutFrame (0),
+    bufferLevel (0),
+    credits (0),
+    quality (QUALITY_ANY),
+    receiveRate (0),
+    lossFraction (0),
+    delay (0),
+    echoTimestamp (0),
+    echoDelay (0)
 {
 
 }
@@ -36,70 +91,235 @@ ClientHeader::Print (std::ostream &os) const
   // This method is invoked by the packet printing
   // routines to print the content of my header.
   //os << "data=" << m_data << std::endl;
-  os << "current state=" << state;
-  os << "current frame=" << currentFrame;
+  os << "flags=" << (uint32_t)flags;
+  os << " playout frame=" << playoutFrame;
+  os << " buffer=" << bufferLevel;
+  os << " credits=" << credits;
+  os << " quality=" << (uint32_t)quality;
+  os << " rate=" << receiveRate << "kbps";
+  os << " loss=" << (uint32_t)lossFraction << "/256";
+  os << " delay=" << delay << "us";
+  os << " echo=" << echoTimestamp << "+" << echoDelay;
+  os << " nack=";
+  for (uint32_t i = 0; i < nackRanges.size (); i++)
+    {
+      os << "[" << nackRanges[i].first << "+" << nackRanges[i].second << "]";
+    }
 }
 uint32_t
 ClientHeader::GetSerializedSize (void) const
 {
-  // we reserve 2 bytes for our header.
+  // 1 (flags) + 4 (frame) + 2 (buffer) + 2 (credits) + 1 (quality)
+  // + 4 (rate) + 1 (loss) + 4 (delay) + 8 (echo) + 2 (range count)
+  uint32_t size = 29;
+  if (nackRanges.empty ())
+    return size;
 
-  // 1 + 2 + 400
-  return 403;
+  // 4 (base sequence) + per range: varint gap from the previous run's end
+  // and varint (length - 1)
+  size += 4;
+  uint32_t prevEnd = nackRanges[0].first;
+  for (uint32_t i = 0; i < nackRanges.size (); i++)
+    {
+      size += VarIntSize (nackRanges[i].first - prevEnd);
+      size += VarIntSize (nackRanges[i].second - 1);
+      prevEnd = nackRanges[i].first + nackRanges[i].second;
+    }
+  return size;
 }
 void
 ClientHeader::Serialize (Buffer::Iterator start) const
 {
-  // we can serialize two bytes at the start of the buffer.
   // we write them in network byte order.
-  start.WriteU8 (state);
-  start.WriteHtonU16 (currentFrame);
-
-  for(uint32_t i=0;i<100;i++){
-	start.WriteHtonU32(retransmitRequest[i]);
-  }
+  start.WriteU8 (flags);
+  start.WriteHtonU32 (playoutFrame);
+  start.WriteHtonU16 (bufferLevel);
+  start.WriteHtonU16 (credits);
+  start.WriteU8 (quality);
+  start.WriteHtonU32 (receiveRate);
+  start.WriteU8 (lossFraction);
+  start.WriteHtonU32 (delay);
+  start.WriteHtonU32 (echoTimestamp);
+  start.WriteHtonU32 (echoDelay);
+  start.WriteHtonU16 (nackRanges.size ());
+  if (nackRanges.empty ())
+    return;
 
+  uint32_t prevEnd = nackRanges[0].first;
+  start.WriteHtonU32 (prevEnd);
+  for (uint32_t i = 0; i < nackRanges.size (); i++)
+    {
+      WriteVarInt (start, nackRanges[i].first - prevEnd);
+      WriteVarInt (start, nackRanges[i].second - 1);
+      prevEnd = nackRanges[i].first + nackRanges[i].second;
+    }
 }
 uint32_t
 ClientHeader::Deserialize (Buffer::Iterator start)
 {
-  // we can deserialize two bytes from the start of the buffer.
   // we read them in network byte order and store them
   // in host byte order.
-  state = start.ReadU8 ();
-  currentFrame = start.ReadNtohU16 ();
-  for(uint32_t i=0;i<100;i++){
-	retransmitRequest[i] = start.ReadNtohU32();
-  }
+  flags = start.ReadU8 ();
+  playoutFrame = start.ReadNtohU32 ();
+  bufferLevel = start.ReadNtohU16 ();
+  credits = start.ReadNtohU16 ();
+  quality = start.ReadU8 ();
+  receiveRate = start.ReadNtohU32 ();
+  lossFraction = start.ReadU8 ();
+  delay = start.ReadNtohU32 ();
+  echoTimestamp = start.ReadNtohU32 ();
+  echoDelay = start.ReadNtohU32 ();
+  uint16_t count = start.ReadNtohU16 ();
+
+  nackRanges.clear ();
+  if (count > 0)
+    {
+      uint32_t prevEnd = start.ReadNtohU32 ();
+      for (uint16_t i = 0; i < count; i++)
+        {
+          uint32_t first = prevEnd + ReadVarInt (start);
+          uint32_t length = ReadVarInt (start) + 1;
+          nackRanges.push_back (std::make_pair (first, length));
+          prevEnd = first + length;
+        }
+    }
 
   // we return the number of bytes effectively read.
   return GetSerializedSize();
 }
 
-void 
-ClientHeader::Set (uint8_t _state, uint16_t _currentFrame, uint32_t* _retransmitRequest)
+void
+ClientHeader::SetFlags (uint8_t _flags)
+{
+  flags = _flags;
+}
+void
+ClientHeader::SetPlayoutFrame (uint32_t _playoutFrame)
+{
+  playoutFrame = _playoutFrame;
+}
+void
+ClientHeader::SetBufferLevel (uint16_t _bufferLevel)
 {
-  state = _state;
-  currentFrame = _currentFrame;
+  bufferLevel = _bufferLevel;
+}
+bool
+ClientHeader::AddNackRange (uint32_t start, uint32_t length)
+{
+  if (length == 0)
+    return true;
+
+  if (!nackRanges.empty ())
+    {
+      std::pair<uint32_t, uint32_t> &last = nackRanges.back ();
+      NS_ASSERT (start >= last.first + last.second);
+      if (start == last.first + last.second)
+        {
+          last.second += length;
+          return true;
+        }
+    }
+  if (nackRanges.size () >= MAX_NACK_RANGES)
+    return false;
 
-  for(uint32_t i=0;i<100;i++){
-	retransmitRequest[i] = _retransmitRequest[i];
-  }
+  nackRanges.push_back (std::make_pair (start, length));
+  return true;
+}
+void
+ClientHeader::SetCredits (uint16_t _credits)
+{
+  credits = _credits;
+}
+void
+ClientHeader::SetQuality (uint8_t _quality)
+{
+  quality = _quality;
+}
+void
+ClientHeader::SetReceiveRate (uint32_t _receiveRate)
+{
+  receiveRate = _receiveRate;
+}
+void
+ClientHeader::SetLossFraction (uint8_t _lossFraction)
+{
+  lossFraction = _lossFraction;
+}
+void
+ClientHeader::SetDelay (uint32_t _delay)
+{
+  delay = _delay;
+}
+void
+ClientHeader::SetEcho (uint32_t timestamp, uint32_t delay)
+{
+  echoTimestamp = timestamp;
+  echoDelay = delay;
 }
 uint8_t
-ClientHeader::GetState (void) const
+ClientHeader::GetFlags (void) const
+{
+  return flags;
+}
+uint32_t
+ClientHeader::GetPlayoutFrame (void) const
 {
-  return state;
+  return playoutFrame;
 }
-uint16_t 
-ClientHeader::GetCurrentFrame (void) const
+uint16_t
+ClientHeader::GetBufferLevel (void) const
 {
-  return currentFrame;
+  return bufferLevel;
 }
-uint32_t* 
-ClientHeader::GetRetransmitRequest (void) 
+uint16_t
+ClientHeader::GetCredits (void) const
+{
+  return credits;
+}
+uint8_t
+ClientHeader::GetQuality (void) const
+{
+  return quality;
+}
+uint32_t
+ClientHeader::GetReceiveRate (void) const
+{
+  return receiveRate;
+}
+uint8_t
+ClientHeader::GetLossFraction (void) const
+{
+  return lossFraction;
+}
+uint32_t
+ClientHeader::GetDelay (void) const
+{
+  return delay;
+}
+uint32_t
+ClientHeader::GetEchoTimestamp (void) const
+{
+  return echoTimestamp;
+}
+uint32_t
+ClientHeader::GetEchoDelay (void) const
+{
+  return echoDelay;
+}
+uint32_t
+ClientHeader::GetNackRangeCount (void) const
+{
+  return nackRanges.size ();
+}
+uint32_t
+ClientHeader::GetNackStart (uint32_t i) const
+{
+  return nackRanges[i].first;
+}
+uint32_t
+ClientHeader::GetNackLength (uint32_t i) const
 {
-  return retransmitRequest;
+  return nackRanges[i].second;
 }
 
 /*
@@ -128,7 +348,7 @@ int main (int argc, char *argv[])
 
   // and check that the destination and source
   // headers contain the same values.
-  NS_ASSERT (sourceHeader.GetCurrentFrame () == destinationHeader.GetCurrentFrame ());
+  NS_ASSERT (sourceHeader.GetPlayoutFrame () == destinationHeader.GetPlayoutFrame ());
 
   return 0;
 }
@@ -2,9 +2,15 @@
 #include "ns3/packet.h"
 #include "ns3/header.h"
 #include <iostream>
+#include <vector>
 
 using namespace ns3;
 
+// Receiver report: the only message a client sends. It carries the
+// playout position, buffer level, credit window, requested quality,
+// measured receive rate, loss fraction and one-way delay, a timestamp
+// echo for RTT, and the missing sequence runs, so one packet replaces
+// separate NACK, pause/resume and rate messages.
 class ClientHeader : public Header 
 {
 public:
@@ -12,10 +18,37 @@ public:
   ClientHeader ();
   virtual ~ClientHeader ();
 
-  void Set (uint8_t, uint16_t, uint32_t*);
-  uint8_t GetState (void) const; 
-  uint16_t GetCurrentFrame (void) const;
-  uint32_t* GetRetransmitRequest (void);
+  void SetFlags (uint8_t);
+  void SetPlayoutFrame (uint32_t);
+  void SetBufferLevel (uint16_t);
+  void SetCredits (uint16_t);
+  void SetQuality (uint8_t);
+  void SetReceiveRate (uint32_t);
+  void SetLossFraction (uint8_t);
+  void SetDelay (uint32_t);
+  void SetEcho (uint32_t timestamp, uint32_t delay);
+  bool AddNackRange (uint32_t start, uint32_t length);
+
+  uint8_t GetFlags (void) const;
+  uint32_t GetPlayoutFrame (void) const;
+  uint16_t GetBufferLevel (void) const;
+  uint16_t GetCredits (void) const;
+  uint8_t GetQuality (void) const;
+  uint32_t GetReceiveRate (void) const;
+  uint8_t GetLossFraction (void) const;
+  uint32_t GetDelay (void) const;
+  uint32_t GetEchoTimestamp (void) const;
+  uint32_t GetEchoDelay (void) const;
+  uint32_t GetNackRangeCount (void) const;
+  uint32_t GetNackStart (uint32_t i) const;
+  uint32_t GetNackLength (uint32_t i) const;
+
+  // set until the client has received data; asks the streamer to open a session
+  static const uint8_t FLAG_JOIN = 0x01;
+  // upper bound on ranges per report, keeps the header well under one MTU
+  static const uint32_t MAX_NACK_RANGES = 128;
+  // quality value meaning "no preference"
+  static const uint8_t QUALITY_ANY = 0xff;
 
   static TypeId GetTypeId (void);
   virtual TypeId GetInstanceTypeId (void) const;
@@ -24,9 +57,24 @@ public:
   virtual uint32_t Deserialize (Buffer::Iterator start);
   virtual uint32_t GetSerializedSize (void) const;
 private:
-  uint8_t state; 
-  uint16_t currentFrame;  
-  uint32_t retransmitRequest[100] = {0};
+  uint8_t flags;
+  uint32_t playoutFrame;
+  // complete frames waiting for playout
+  uint16_t bufferLevel;
+  // frames past playoutFrame the streamer may send
+  uint16_t credits;
+  uint8_t quality;
+  // kbit/s received since the previous report
+  uint32_t receiveRate;
+  // data packets lost since the previous report, in 1/256 (RTCP fraction lost)
+  uint8_t lossFraction;
+  // mean one-way delay of the data packets since the previous report (us)
+  uint32_t delay;
+  // send time of the newest data packet (us) and how long it was held (us)
+  uint32_t echoTimestamp;
+  uint32_t echoDelay;
+  // missing sequence runs as (start, length), ascending and disjoint
+  std::vector<std::pair<uint32_t, uint32_t> > nackRanges;
 };
 
 
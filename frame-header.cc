@@ -0,0 +1,143 @@
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/header.h"
+#include "frame-header.h"
+#include <iostream>
+
+using namespace ns3;
+
+FrameHeader::FrameHeader ()
+  : frameIdx (0),
+    packetIdx (0),
+    framePackets (0),
+    quality (0),
+    fecGroup (0),
+    flags (0),
+    frameBytes (0)
+{
+
+}
+FrameHeader::~FrameHeader ()
+{
+
+}
+
+TypeId
+FrameHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FrameHeader")
+    .SetParent<Header> ()
+    .AddConstructor<FrameHeader> ()
+  ;
+  return tid;
+}
+TypeId
+FrameHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+FrameHeader::Print (std::ostream &os) const
+{
+  os << "frame=" << frameIdx;
+  os << " packet=" << packetIdx << "/" << framePackets;
+  os << " quality=" << (uint32_t)quality;
+  os << " type=" << (uint32_t)GetFrameType ();
+  os << " bytes=" << frameBytes;
+  os << " fec=" << (uint32_t)fecGroup;
+  if (IsParity ())
+    os << " parity";
+}
+uint32_t
+FrameHeader::GetSerializedSize (void) const
+{
+  // 4 + 2 + 2 + 1 + 1 + 1 + 4
+  return 15;
+}
+void
+FrameHeader::Serialize (Buffer::Iterator start) const
+{
+  start.WriteHtonU32 (frameIdx);
+  start.WriteHtonU16 (packetIdx);
+  start.WriteHtonU16 (framePackets);
+  start.WriteU8 (quality);
+  start.WriteU8 (fecGroup);
+  start.WriteU8 (flags);
+  start.WriteHtonU32 (frameBytes);
+}
+uint32_t
+FrameHeader::Deserialize (Buffer::Iterator start)
+{
+  frameIdx = start.ReadNtohU32 ();
+  packetIdx = start.ReadNtohU16 ();
+  framePackets = start.ReadNtohU16 ();
+  quality = start.ReadU8 ();
+  fecGroup = start.ReadU8 ();
+  flags = start.ReadU8 ();
+  frameBytes = start.ReadNtohU32 ();
+
+  return GetSerializedSize();
+}
+
+void 
+FrameHeader::Set (uint32_t _frameIdx, uint16_t _packetIdx, uint16_t _framePackets, uint8_t _quality)
+{
+  frameIdx = _frameIdx;
+  packetIdx = _packetIdx;
+  framePackets = _framePackets;
+  quality = _quality;
+}
+void
+FrameHeader::SetFec (uint8_t _groupSize, bool _parity)
+{
+  fecGroup = _groupSize;
+  flags = _parity ? (flags | 0x01) : (flags & ~0x01);
+}
+void
+FrameHeader::SetFrameInfo (uint8_t _type, uint32_t _bytes)
+{
+  // frame type lives in flag bits 1-2
+  flags = (flags & ~0x06) | ((_type & 0x03) << 1);
+  frameBytes = _bytes;
+}
+uint32_t
+FrameHeader::GetFrameIndex (void) const
+{
+  return frameIdx;
+}
+uint16_t
+FrameHeader::GetPacketIndex (void) const
+{
+  return packetIdx;
+}
+uint16_t
+FrameHeader::GetFramePackets (void) const
+{
+  return framePackets;
+}
+uint8_t
+FrameHeader::GetQuality (void) const
+{
+  return quality;
+}
+uint8_t
+FrameHeader::GetFecGroup (void) const
+{
+  return fecGroup;
+}
+bool
+FrameHeader::IsParity (void) const
+{
+  return flags & 0x01;
+}
+uint8_t
+FrameHeader::GetFrameType (void) const
+{
+  return (flags >> 1) & 0x03;
+}
+uint32_t
+FrameHeader::GetFrameBytes (void) const
+{
+  return frameBytes;
+}
@@ -0,0 +1,51 @@
+#ifndef FRAME_HEADER_H
+#define FRAME_HEADER_H
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/header.h"
+#include <iostream>
+
+using namespace ns3;
+
+// Carried by every data packet behind the SeqTsHeader so the client can
+// assemble frames whose packet count changes from frame to frame.
+class FrameHeader : public Header 
+{
+public:
+
+  FrameHeader ();
+  virtual ~FrameHeader ();
+
+  void Set (uint32_t frameIdx, uint16_t packetIdx, uint16_t framePackets, uint8_t quality);
+  // groupSize data packets share one XOR parity packet; 0 means no FEC.
+  // For a parity packet the packet index is the group index.
+  void SetFec (uint8_t groupSize, bool parity);
+  // encoded size in bytes and FrameTrace::FrameType of the whole frame
+  void SetFrameInfo (uint8_t type, uint32_t bytes);
+  uint32_t GetFrameIndex (void) const;
+  uint16_t GetPacketIndex (void) const;
+  uint16_t GetFramePackets (void) const;
+  uint8_t GetQuality (void) const;
+  uint8_t GetFecGroup (void) const;
+  bool IsParity (void) const;
+  uint8_t GetFrameType (void) const;
+  uint32_t GetFrameBytes (void) const;
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
+private:
+  uint32_t frameIdx;
+  uint16_t packetIdx;
+  uint16_t framePackets;
+  uint8_t quality;
+  uint8_t fecGroup;
+  uint8_t flags;
+  uint32_t frameBytes;
+};
+
+#endif
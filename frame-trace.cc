@@ -0,0 +1,124 @@
+#include "frame-trace.h"
+
+#include <cstdlib>
+#include <fstream>
+
+namespace ns3 {
+
+namespace {
+
+bool
+ParseType (const std::string &token, uint8_t &type)
+{
+	if (token.size () != 1)
+		return false;
+	switch (token[0])
+	{
+		case 'I': case 'i': type = FrameTrace::FRAME_I; return true;
+		case 'P': case 'p': type = FrameTrace::FRAME_P; return true;
+		case 'B': case 'b': type = FrameTrace::FRAME_B; return true;
+	}
+	return false;
+}
+
+bool
+ParseBytes (const std::string &token, uint32_t &bytes)
+{
+	if (token.empty ())
+		return false;
+	char *end = 0;
+	unsigned long value = std::strtoul (token.c_str (), &end, 10);
+	if (*end != '\0')
+		return false;
+	bytes = value;
+	return true;
+}
+
+}
+
+FrameTrace::FrameTrace ()
+	: m_totalBytes (0)
+{
+}
+
+bool
+FrameTrace::Load (const std::string &path)
+{
+	std::ifstream in (path.c_str ());
+	if (!in)
+		return false;
+
+	m_frames.clear ();
+	m_totalBytes = 0;
+	std::string line;
+	std::vector<std::string> tokens;
+	while (std::getline (in, line))
+	{
+		if (line.empty () || line[0] == '#')
+			continue;
+
+		tokens.clear ();
+		std::string::size_type pos = 0;
+		while (pos < line.size ())
+		{
+			std::string::size_type start = line.find_first_not_of (", \t\r;", pos);
+			if (start == std::string::npos)
+				break;
+			pos = line.find_first_of (", \t\r;", start);
+			tokens.push_back (line.substr (start, pos == std::string::npos ? std::string::npos : pos - start));
+		}
+
+		Entry entry;
+		uint32_t i = 0;
+		while (i < tokens.size () && !ParseType (tokens[i], entry.type))
+			i++;
+		while (++i < tokens.size () && !ParseBytes (tokens[i], entry.bytes))
+			;
+		if (i >= tokens.size ())
+			continue;
+
+		m_frames.push_back (entry);
+		m_totalBytes += entry.bytes;
+	}
+	return !m_frames.empty ();
+}
+
+bool
+FrameTrace::IsEmpty (void) const
+{
+	return m_frames.empty ();
+}
+
+uint32_t
+FrameTrace::GetFrameCount (void) const
+{
+	return m_frames.size ();
+}
+
+const FrameTrace::Entry&
+FrameTrace::Get (uint32_t frameIdx) const
+{
+	return m_frames[frameIdx % m_frames.size ()];
+}
+
+double
+FrameTrace::GetMeanBytes (void) const
+{
+	if (m_frames.empty ())
+		return 0;
+	return (double)m_totalBytes / m_frames.size ();
+}
+
+char
+FrameTrace::TypeName (uint8_t type)
+{
+	switch (type)
+	{
+		case FRAME_I: return 'I';
+		case FRAME_P: return 'P';
+		case FRAME_B: return 'B';
+	}
+	return '?';
+}
+
+}
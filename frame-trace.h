@@ -0,0 +1,51 @@
+#ifndef FRAME_TRACE_H
+#define FRAME_TRACE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+// Per-frame sizes and types of an encoded video, replayed by the streamer
+// in place of fixed FramePackets frames. Accepts "frameNo,type,bytes" CSV
+// and the whitespace-separated ASU/TKN traces ("frameNo time type bytes
+// ..."): on each line the first I/P/B token is the type and the next
+// integer the size. Lines without one (headers, comments) are skipped.
+// Frames replay in file order and the trace loops when it runs out.
+class FrameTrace
+{
+public:
+	enum FrameType
+	{
+		FRAME_I = 0,
+		FRAME_P = 1,
+		FRAME_B = 2
+	};
+
+	struct Entry
+	{
+		uint32_t bytes;
+		uint8_t type;
+	};
+
+	FrameTrace ();
+
+	// reads the file line by line; false if it cannot be opened or has no frames
+	bool Load (const std::string &path);
+
+	bool IsEmpty (void) const;
+	uint32_t GetFrameCount (void) const;
+	const Entry& Get (uint32_t frameIdx) const;
+	double GetMeanBytes (void) const;
+
+	static char TypeName (uint8_t type);
+
+private:
+	std::vector<Entry> m_frames;
+	uint64_t m_totalBytes;
+};
+
+}
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef FRAME_WINDOW_H
+#define FRAME_WINDOW_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+// Fixed-capacity sliding window keyed by frame index.
+// Frame f lives in slot f % capacity while base <= f < base + capacity,
+// so insert, lookup and eviction are O(1) and slots are reused in place.
+template <typename T>
+class FrameWindow
+{
+public:
+	FrameWindow ();
+
+	void SetCapacity (uint32_t capacity);
+	uint32_t GetCapacity (void) const;
+	uint32_t GetBase (void) const;
+	uint32_t GetSize (void) const;
+
+	bool InWindow (uint32_t frameIdx) const;
+	T* Find (uint32_t frameIdx);
+	// Claims the slot for frameIdx and returns it, or 0 if the frame lies
+	// outside the window. A newly claimed slot keeps whatever the previous
+	// occupant left behind, so the caller is expected to reset it.
+	T* Insert (uint32_t frameIdx);
+	void Erase (uint32_t frameIdx);
+	// Slides the window forward, evicting every frame below base.
+	void Advance (uint32_t base);
+
+private:
+	struct Slot
+	{
+		uint32_t frameIdx;
+		bool used;
+		T value;
+	};
+
+	std::vector<Slot> m_slots;
+	uint32_t m_base;
+	uint32_t m_size;
+};
+
+template <typename T>
+FrameWindow<T>::FrameWindow ()
+	: m_base (0),
+	  m_size (0)
+{
+}
+
+template <typename T>
+void
+FrameWindow<T>::SetCapacity (uint32_t capacity)
+{
+	m_slots.assign (capacity, Slot ());
+	for (uint32_t i = 0; i < capacity; i++)
+		m_slots[i].used = false;
+	m_size = 0;
+}
+
+template <typename T>
+uint32_t
+FrameWindow<T>::GetCapacity (void) const
+{
+	return m_slots.size ();
+}
+
+template <typename T>
+uint32_t
+FrameWindow<T>::GetBase (void) const
+{
+	return m_base;
+}
+
+template <typename T>
+uint32_t
+FrameWindow<T>::GetSize (void) const
+{
+	return m_size;
+}
+
+template <typename T>
+bool
+FrameWindow<T>::InWindow (uint32_t frameIdx) const
+{
+	return frameIdx >= m_base && frameIdx - m_base < m_slots.size ();
+}
+
+template <typename T>
+T*
+FrameWindow<T>::Find (uint32_t frameIdx)
+{
+	if (!InWindow (frameIdx))
+		return 0;
+
+	Slot &slot = m_slots[frameIdx % m_slots.size ()];
+	if (!slot.used || slot.frameIdx != frameIdx)
+		return 0;
+	return &slot.value;
+}
+
+template <typename T>
+T*
+FrameWindow<T>::Insert (uint32_t frameIdx)
+{
+	if (!InWindow (frameIdx))
+		return 0;
+
+	Slot &slot = m_slots[frameIdx % m_slots.size ()];
+	if (!slot.used)
+	{
+		slot.used = true;
+		m_size++;
+	}
+	slot.frameIdx = frameIdx;
+	return &slot.value;
+}
+
+template <typename T>
+void
+FrameWindow<T>::Erase (uint32_t frameIdx)
+{
+	if (!InWindow (frameIdx))
+		return;
+
+	Slot &slot = m_slots[frameIdx % m_slots.size ()];
+	if (slot.used && slot.frameIdx == frameIdx)
+	{
+		slot.used = false;
+		m_size--;
+	}
+}
+
+template <typename T>
+void
+FrameWindow<T>::Advance (uint32_t base)
+{
+	if (base <= m_base)
+		return;
+
+	if (base - m_base >= m_slots.size ())
+	{
+		for (uint32_t i = 0; i < m_slots.size (); i++)
+			m_slots[i].used = false;
+		m_size = 0;
+	}
+	else
+	{
+		for (uint32_t idx = m_base; idx < base; idx++)
+			Erase (idx);
+	}
+	m_base = base;
+}
+
+}
+
+#endif
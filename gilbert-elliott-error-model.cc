@@ -0,0 +1,100 @@
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/packet.h"
+#include "gilbert-elliott-error-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("GilbertElliottErrorModel");
+
+NS_OBJECT_ENSURE_REGISTERED (GilbertElliottErrorModel);
+
+TypeId
+GilbertElliottErrorModel::GetTypeId (void)
+{
+	static TypeId tid = TypeId ("ns3::GilbertElliottErrorModel")
+		.SetParent<ErrorModel> ()
+		.AddConstructor<GilbertElliottErrorModel> ()
+    .AddAttribute ("MeanBurstLength", 
+                   "Mean number of packets spent in the bad state",
+                   DoubleValue (3.0),
+                   MakeDoubleAccessor (&GilbertElliottErrorModel::m_meanBurst),
+                   MakeDoubleChecker<double> (1.0))
+    .AddAttribute ("MeanGapLength", 
+                   "Mean number of packets spent in the good state",
+                   DoubleValue (100.0),
+                   MakeDoubleAccessor (&GilbertElliottErrorModel::m_meanGap),
+                   MakeDoubleChecker<double> (1.0))
+    .AddAttribute ("GoodLossProbability", 
+                   "Loss probability while in the good state",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&GilbertElliottErrorModel::m_lossGood),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("BadLossProbability", 
+                   "Loss probability while in the bad state",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&GilbertElliottErrorModel::m_lossBad),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+		;
+	return tid;
+}
+
+GilbertElliottErrorModel::GilbertElliottErrorModel ()
+{
+	NS_LOG_FUNCTION (this);
+	m_bad = false;
+	m_ranvar = CreateObject<UniformRandomVariable> ();
+}
+
+GilbertElliottErrorModel::~GilbertElliottErrorModel ()
+{
+	NS_LOG_FUNCTION (this);
+}
+
+int64_t
+GilbertElliottErrorModel::AssignStreams (int64_t stream)
+{
+	NS_LOG_FUNCTION (this << stream);
+	m_ranvar->SetStream (stream);
+	return 1;
+}
+
+bool
+GilbertElliottErrorModel::IsBad (void) const
+{
+	return m_bad;
+}
+
+bool
+GilbertElliottErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+	NS_LOG_FUNCTION (this << p);
+
+	// leave the current state with probability 1 / mean sojourn
+	if (m_bad)
+	{
+		if (m_ranvar->GetValue () < 1.0 / m_meanBurst)
+			m_bad = false;
+	}
+	else
+	{
+		if (m_ranvar->GetValue () < 1.0 / m_meanGap)
+			m_bad = true;
+	}
+
+	double loss = m_bad ? m_lossBad : m_lossGood;
+	if (loss <= 0)
+		return false;
+	if (loss >= 1)
+		return true;
+	return m_ranvar->GetValue () < loss;
+}
+
+void
+GilbertElliottErrorModel::DoReset (void)
+{
+	NS_LOG_FUNCTION (this);
+	m_bad = false;
+}
+
+}
@@ -0,0 +1,46 @@
+#ifndef GILBERT_ELLIOTT_ERROR_MODEL_H
+#define GILBERT_ELLIOTT_ERROR_MODEL_H
+
+#include "ns3/error-model.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+// Two-state burst-loss model. Each packet first moves the channel between
+// a good and a bad state, then is lost with that state's loss probability.
+// Sojourn times are geometric, so MeanGapLength and MeanBurstLength are the
+// average number of packets spent in the good and the bad state; with the
+// default loss probabilities (0 good, 1 bad) the long-run loss rate is
+// burst / (burst + gap).
+//
+// Attach one instance per receiver: as the streaming apps'
+// ReceiveErrorModel, a PointToPointNetDevice ReceiveErrorModel, or a
+// WifiPhy PostReceptionErrorModel. On the Wi-Fi PHY the loss sits below
+// MAC retries and BlockAck, so unicast traffic sees little of it.
+class GilbertElliottErrorModel : public ErrorModel
+{
+public:
+	static TypeId GetTypeId (void);
+
+	GilbertElliottErrorModel ();
+	virtual ~GilbertElliottErrorModel ();
+
+	// Assigns a fixed stream to the model's RNG; returns the number of streams used.
+	int64_t AssignStreams (int64_t stream);
+	bool IsBad (void) const;
+
+private:
+	virtual bool DoCorrupt (Ptr<Packet> p);
+	virtual void DoReset (void);
+
+	double m_meanBurst;
+	double m_meanGap;
+	double m_lossGood;
+	double m_lossBad;
+	bool m_bad;
+	Ptr<UniformRandomVariable> m_ranvar;
+};
+
+}
+
+#endif
@@ -0,0 +1,255 @@
+#include "ns3/simulator.h"
+#include "ns3/callback.h"
+#include <algorithm>
+#include "qoe-collector.h"
+#include "streaming-client.h"
+
+namespace ns3 {
+
+QoeCollector::QoeCollector ()
+	: m_playing (false),
+	  m_stalled (false),
+	  m_bufferLevel (0),
+	  m_goodput (0),
+	  m_goodputSum (0),
+	  m_goodputSamples (0),
+	  m_completed (0),
+	  m_consumed (0),
+	  m_skipped (0),
+	  m_stalls (0),
+	  m_nacked (0),
+	  m_delayCount (0),
+	  m_spreadCount (0),
+	  m_delayHistogram (HISTOGRAM_BINS, 0),
+	  m_spreadHistogram (HISTOGRAM_BINS, 0),
+	  m_intervalCompleted (0),
+	  m_intervalConsumed (0),
+	  m_intervalSkipped (0),
+	  m_intervalNacked (0),
+	  m_intervalDelayCount (0),
+	  m_intervalSpreadCount (0)
+{
+}
+
+QoeCollector::~QoeCollector ()
+{
+	Simulator::Cancel (m_sampleEvent);
+}
+
+void
+QoeCollector::Attach (Ptr<StreamingClient> client)
+{
+	m_start = Simulator::Now ();
+	client->TraceConnectWithoutContext ("FrameComplete", MakeCallback (&QoeCollector::FrameComplete, this));
+	client->TraceConnectWithoutContext ("FrameConsumed", MakeCallback (&QoeCollector::FrameConsumed, this));
+	client->TraceConnectWithoutContext ("FrameSkipped", MakeCallback (&QoeCollector::FrameSkipped, this));
+	client->TraceConnectWithoutContext ("StallStart", MakeCallback (&QoeCollector::StallStart, this));
+	client->TraceConnectWithoutContext ("StallEnd", MakeCallback (&QoeCollector::StallEnd, this));
+	client->TraceConnectWithoutContext ("BufferLevel", MakeCallback (&QoeCollector::BufferLevel, this));
+	client->TraceConnectWithoutContext ("LossDetected", MakeCallback (&QoeCollector::LossDetected, this));
+	client->TraceConnectWithoutContext ("Goodput", MakeCallback (&QoeCollector::Goodput, this));
+	client->TraceConnectWithoutContext ("PacketDelay", MakeCallback (&QoeCollector::PacketDelay, this));
+	client->TraceConnectWithoutContext ("Jitter", MakeCallback (&QoeCollector::Jitter, this));
+	client->TraceConnectWithoutContext ("FrameSpread", MakeCallback (&QoeCollector::FrameSpread, this));
+}
+
+void
+QoeCollector::EnableTimeSeries (const std::string &path, Time interval)
+{
+	m_series.open (path.c_str ());
+	m_series << "time,buffer,goodput_bps,completed,consumed,skipped,stalled,nacked,delay_ms,jitter_ms,spread_ms" << std::endl;
+	m_interval = interval;
+	m_sampleEvent = Simulator::Schedule (m_interval, &QoeCollector::Sample, this);
+}
+
+void
+QoeCollector::Sample (void)
+{
+	m_series << Simulator::Now ().GetSeconds () << "," << m_bufferLevel << "," << m_goodput
+		<< "," << m_intervalCompleted << "," << m_intervalConsumed << "," << m_intervalSkipped
+		<< "," << (m_stalled ? 1 : 0) << "," << m_intervalNacked
+		<< "," << (m_intervalDelayCount > 0 ? m_intervalDelay.GetSeconds () * 1000 / m_intervalDelayCount : 0)
+		<< "," << m_jitter.GetSeconds () * 1000
+		<< "," << (m_intervalSpreadCount > 0 ? m_intervalSpread.GetSeconds () * 1000 / m_intervalSpreadCount : 0)
+		<< std::endl;
+	m_intervalCompleted = 0;
+	m_intervalConsumed = 0;
+	m_intervalSkipped = 0;
+	m_intervalNacked = 0;
+	m_intervalDelay = Seconds (0);
+	m_intervalDelayCount = 0;
+	m_intervalSpread = Seconds (0);
+	m_intervalSpreadCount = 0;
+
+	m_sampleEvent = Simulator::Schedule (m_interval, &QoeCollector::Sample, this);
+}
+
+void
+QoeCollector::WriteSummary (const std::string &path) const
+{
+	// a stall still running at the end counts up to now
+	Time stallTime = m_stallTime;
+	if (m_stalled)
+		stallTime += Simulator::Now () - m_stallStart;
+	double startup = m_playing ? (m_firstFrame - m_start).GetSeconds () : -1;
+	double bitrate = m_goodputSamples > 0 ? m_goodputSum / m_goodputSamples : 0;
+	double delay = m_delayCount > 0 ? m_delaySum.GetSeconds () / m_delayCount : 0;
+	double delayP95 = Percentile (m_delayHistogram, 0.95);
+	double spread = m_spreadCount > 0 ? m_spreadSum.GetSeconds () / m_spreadCount : 0;
+
+	std::ofstream out (path.c_str ());
+	if (path.size () >= 5 && path.compare (path.size () - 5, 5, ".json") == 0)
+	{
+		out << "{" << std::endl
+			<< "  \"startup_delay\": " << startup << "," << std::endl
+			<< "  \"stall_count\": " << m_stalls << "," << std::endl
+			<< "  \"stall_time\": " << stallTime.GetSeconds () << "," << std::endl
+			<< "  \"frames_completed\": " << m_completed << "," << std::endl
+			<< "  \"frames_consumed\": " << m_consumed << "," << std::endl
+			<< "  \"frames_skipped\": " << m_skipped << "," << std::endl
+			<< "  \"nacked_packets\": " << m_nacked << "," << std::endl
+			<< "  \"average_bitrate\": " << bitrate << "," << std::endl
+			<< "  \"delay_mean\": " << delay << "," << std::endl
+			<< "  \"delay_p95\": " << delayP95 << "," << std::endl
+			<< "  \"jitter\": " << m_jitter.GetSeconds () << "," << std::endl
+			<< "  \"frame_spread_mean\": " << spread << std::endl
+			<< "}" << std::endl;
+	}
+	else
+	{
+		out << "startup_delay,stall_count,stall_time,frames_completed,frames_consumed,frames_skipped,nacked_packets,average_bitrate,"
+			<< "delay_mean,delay_p95,jitter,frame_spread_mean" << std::endl
+			<< startup << "," << m_stalls << "," << stallTime.GetSeconds () << "," << m_completed
+			<< "," << m_consumed << "," << m_skipped << "," << m_nacked << "," << bitrate
+			<< "," << delay << "," << delayP95 << "," << m_jitter.GetSeconds () << "," << spread << std::endl;
+	}
+}
+
+void
+QoeCollector::WriteHistogram (const std::string &path) const
+{
+	std::ofstream out (path.c_str ());
+	out << "bin_ms,delay_packets,spread_frames" << std::endl;
+	for (uint32_t i = 0; i < HISTOGRAM_BINS; i++)
+	{
+		out << i << "," << m_delayHistogram[i] << "," << m_spreadHistogram[i] << std::endl;
+	}
+}
+
+void
+QoeCollector::AddToHistogram (std::vector<uint64_t> &histogram, Time value)
+{
+	int64_t bin = value.GetMilliSeconds ();
+	if (bin < 0)
+		bin = 0;
+	histogram[std::min<int64_t> (bin, HISTOGRAM_BINS - 1)]++;
+}
+
+double
+QoeCollector::Percentile (const std::vector<uint64_t> &histogram, double fraction)
+{
+	uint64_t total = 0;
+	for (uint32_t i = 0; i < histogram.size (); i++)
+		total += histogram[i];
+	if (total == 0)
+		return 0;
+
+	uint64_t seen = 0;
+	for (uint32_t i = 0; i < histogram.size (); i++)
+	{
+		seen += histogram[i];
+		if (seen >= fraction * total)
+			return (i + 1) / 1000.0;
+	}
+	return histogram.size () / 1000.0;
+}
+
+void
+QoeCollector::FrameComplete (uint32_t frameIdx)
+{
+	m_completed++;
+	m_intervalCompleted++;
+}
+
+void
+QoeCollector::FrameConsumed (uint32_t frameIdx)
+{
+	if (!m_playing)
+	{
+		m_playing = true;
+		m_firstFrame = Simulator::Now ();
+	}
+	m_consumed++;
+	m_intervalConsumed++;
+}
+
+void
+QoeCollector::FrameSkipped (uint32_t frameIdx)
+{
+	m_skipped++;
+	m_intervalSkipped++;
+}
+
+void
+QoeCollector::StallStart (uint32_t frameIdx)
+{
+	m_stalled = true;
+	m_stallStart = Simulator::Now ();
+	m_stalls++;
+}
+
+void
+QoeCollector::StallEnd (Time duration)
+{
+	m_stalled = false;
+	m_stallTime += duration;
+}
+
+void
+QoeCollector::BufferLevel (uint32_t frames)
+{
+	m_bufferLevel = frames;
+}
+
+void
+QoeCollector::LossDetected (uint32_t count)
+{
+	m_nacked += count;
+	m_intervalNacked += count;
+}
+
+void
+QoeCollector::Goodput (double bps)
+{
+	m_goodput = bps;
+	m_goodputSum += bps;
+	m_goodputSamples++;
+}
+
+void
+QoeCollector::PacketDelay (Time delay)
+{
+	m_delaySum += delay;
+	m_delayCount++;
+	m_intervalDelay += delay;
+	m_intervalDelayCount++;
+	AddToHistogram (m_delayHistogram, delay);
+}
+
+void
+QoeCollector::Jitter (Time jitter)
+{
+	m_jitter = jitter;
+}
+
+void
+QoeCollector::FrameSpread (Time spread)
+{
+	m_spreadSum += spread;
+	m_spreadCount++;
+	m_intervalSpread += spread;
+	m_intervalSpreadCount++;
+	AddToHistogram (m_spreadHistogram, spread);
+}
+
+}
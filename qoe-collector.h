@@ -0,0 +1,102 @@
+#ifndef QOE_COLLECTOR_H
+#define QOE_COLLECTOR_H
+
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+class StreamingClient;
+
+// Listens to one StreamingClient's trace sources and turns them into a
+// per-interval CSV time series and an end-of-run QoE summary: startup
+// delay, stall count and time, skipped frames, average goodput and
+// packet delay, jitter and frame spread.
+class QoeCollector
+{
+public:
+	QoeCollector ();
+	~QoeCollector ();
+
+	// Connects to the client's traces; startup delay is measured from now.
+	void Attach (Ptr<StreamingClient> client);
+	// Writes time,buffer,goodput_bps,completed,consumed,skipped,stalled,nacked,
+	// delay_ms,jitter_ms,spread_ms every interval; delay and spread are
+	// interval means, jitter the latest estimate.
+	void EnableTimeSeries (const std::string &path, Time interval);
+	// JSON when path ends in ".json", otherwise a CSV header and row.
+	void WriteSummary (const std::string &path) const;
+	// Packet delay and frame spread counts in 1 ms bins as
+	// bin_ms,delay_packets,spread_frames; the last bin holds everything longer.
+	void WriteHistogram (const std::string &path) const;
+
+	static const uint32_t HISTOGRAM_BINS = 500;
+
+private:
+	void FrameComplete (uint32_t frameIdx);
+	void FrameConsumed (uint32_t frameIdx);
+	void FrameSkipped (uint32_t frameIdx);
+	void StallStart (uint32_t frameIdx);
+	void StallEnd (Time duration);
+	void BufferLevel (uint32_t frames);
+	void LossDetected (uint32_t count);
+	void Goodput (double bps);
+	void PacketDelay (Time delay);
+	void Jitter (Time jitter);
+	void FrameSpread (Time spread);
+	void Sample (void);
+	static void AddToHistogram (std::vector<uint64_t> &histogram, Time value);
+	// upper edge of the bin holding the given fraction of the samples
+	static double Percentile (const std::vector<uint64_t> &histogram, double fraction);
+
+	Time m_start;
+	Time m_firstFrame;
+	bool m_playing;
+	bool m_stalled;
+	Time m_stallStart;
+	Time m_stallTime;
+
+	uint32_t m_bufferLevel;
+	double m_goodput;
+	double m_goodputSum;
+	uint64_t m_goodputSamples;
+
+	uint64_t m_completed;
+	uint64_t m_consumed;
+	uint64_t m_skipped;
+	uint64_t m_stalls;
+	// distinct lost packets queued for NACK, however often they are re-requested
+	uint64_t m_nacked;
+
+	Time m_delaySum;
+	uint64_t m_delayCount;
+	Time m_jitter;
+	Time m_spreadSum;
+	uint64_t m_spreadCount;
+	std::vector<uint64_t> m_delayHistogram;
+	std::vector<uint64_t> m_spreadHistogram;
+
+	// counts since the previous time-series row
+	uint64_t m_intervalCompleted;
+	uint64_t m_intervalConsumed;
+	uint64_t m_intervalSkipped;
+	uint64_t m_intervalNacked;
+	Time m_intervalDelay;
+	uint64_t m_intervalDelayCount;
+	Time m_intervalSpread;
+	uint64_t m_intervalSpreadCount;
+
+	std::ofstream m_series;
+	Time m_interval;
+	EventId m_sampleEvent;
+};
+
+}
+
+#endif
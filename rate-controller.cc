@@ -0,0 +1,282 @@
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/trace-source-accessor.h"
+#include "rate-controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("StreamingRateController");
+
+NS_OBJECT_ENSURE_REGISTERED (StreamingRateController);
+NS_OBJECT_ENSURE_REGISTERED (AimdRateController);
+NS_OBJECT_ENSURE_REGISTERED (GccRateController);
+
+TypeId
+StreamingRateController::GetTypeId (void)
+{
+	static TypeId tid = TypeId ("ns3::StreamingRateController")
+		.SetParent<Object> ()
+    .AddAttribute ("InitialRate",
+                   "Send rate before the first receiver report",
+                   DataRateValue (DataRate ("20Mbps")),
+                   MakeDataRateAccessor (&StreamingRateController::m_initialRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("MinRate",
+                   "Lowest send rate the controller may choose",
+                   DataRateValue (DataRate ("1Mbps")),
+                   MakeDataRateAccessor (&StreamingRateController::m_minRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("MaxRate",
+                   "Highest send rate the controller may choose",
+                   DataRateValue (DataRate ("200Mbps")),
+                   MakeDataRateAccessor (&StreamingRateController::m_maxRate),
+                   MakeDataRateChecker ())
+    .AddTraceSource ("Rate",
+                     "Send rate in bit/s after each receiver report",
+                     MakeTraceSourceAccessor (&StreamingRateController::m_rate),
+                     "ns3::TracedValueCallback::Uint64")
+		;
+	return tid;
+}
+
+StreamingRateController::StreamingRateController ()
+{
+	NS_LOG_FUNCTION (this);
+	m_rate = 0;
+}
+
+StreamingRateController::~StreamingRateController ()
+{
+	NS_LOG_FUNCTION (this);
+}
+
+void
+StreamingRateController::NotifyConstructionCompleted (void)
+{
+	// attributes are set by now
+	m_rate = m_initialRate.GetBitRate ();
+}
+
+void
+StreamingRateController::Update (const RateFeedback &feedback)
+{
+	NS_LOG_FUNCTION (this << feedback.lossFraction << feedback.receiveRate << feedback.delay);
+	double rate = DoUpdate (feedback, m_rate);
+	rate = std::max<double> (rate, m_minRate.GetBitRate ());
+	rate = std::min<double> (rate, m_maxRate.GetBitRate ());
+	m_rate = rate;
+}
+
+DataRate
+StreamingRateController::GetRate (void) const
+{
+	return DataRate (m_rate);
+}
+
+TypeId
+AimdRateController::GetTypeId (void)
+{
+	static TypeId tid = TypeId ("ns3::AimdRateController")
+		.SetParent<StreamingRateController> ()
+		.AddConstructor<AimdRateController> ()
+    .AddAttribute ("AdditiveIncrease",
+                   "Rate added per second while loss stays under the threshold",
+                   DataRateValue (DataRate ("5Mbps")),
+                   MakeDataRateAccessor (&AimdRateController::m_increase),
+                   MakeDataRateChecker ())
+    .AddAttribute ("DecreaseFactor",
+                   "Factor applied to the rate on loss",
+                   DoubleValue (0.7),
+                   MakeDoubleAccessor (&AimdRateController::m_decrease),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("LossThreshold",
+                   "Reported loss fraction above which the rate is cut",
+                   DoubleValue (0.02),
+                   MakeDoubleAccessor (&AimdRateController::m_lossThreshold),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+		;
+	return tid;
+}
+
+AimdRateController::AimdRateController ()
+{
+	NS_LOG_FUNCTION (this);
+}
+
+AimdRateController::~AimdRateController ()
+{
+	NS_LOG_FUNCTION (this);
+}
+
+double
+AimdRateController::DoUpdate (const RateFeedback &feedback, double rate)
+{
+	Time elapsed = m_lastUpdate.IsZero () ? Seconds (0) : feedback.now - m_lastUpdate;
+	m_lastUpdate = feedback.now;
+
+	if (feedback.lossFraction > m_lossThreshold)
+	{
+		// one loss episode per round trip: later reports describe the same one
+		Time rtt = std::max (feedback.rtt, MilliSeconds (10));
+		if (m_lastDecrease.IsZero () || feedback.now - m_lastDecrease >= rtt)
+		{
+			m_lastDecrease = feedback.now;
+			NS_LOG_LOGIC ("Loss " << feedback.lossFraction << ", decrease");
+			return rate * m_decrease;
+		}
+		return rate;
+	}
+	return rate + m_increase.GetBitRate () * elapsed.GetSeconds ();
+}
+
+TypeId
+GccRateController::GetTypeId (void)
+{
+	static TypeId tid = TypeId ("ns3::GccRateController")
+		.SetParent<StreamingRateController> ()
+		.AddConstructor<GccRateController> ()
+    .AddAttribute ("Beta",
+                   "Share of the receive rate kept on overuse",
+                   DoubleValue (0.85),
+                   MakeDoubleAccessor (&GccRateController::m_beta),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("IncreaseRate",
+                   "Multiplicative increase per second in normal use (0.08 = 8%)",
+                   DoubleValue (0.08),
+                   MakeDoubleAccessor (&GccRateController::m_increaseRate),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TrendlineWindow",
+                   "Reports in the delay trendline",
+                   UintegerValue (20),
+                   MakeUintegerAccessor (&GccRateController::m_window),
+                   MakeUintegerChecker<uint32_t> (2))
+		;
+	return tid;
+}
+
+GccRateController::GccRateController ()
+{
+	NS_LOG_FUNCTION (this);
+	m_smoothedDelay = 0;
+	m_sampleCount = 0;
+	m_threshold = 12.5;
+	m_prevTrend = 0;
+	m_state = HOLD;
+	m_delayRate = 0;
+	m_lossRate = 0;
+	m_started = false;
+}
+
+GccRateController::~GccRateController ()
+{
+	NS_LOG_FUNCTION (this);
+}
+
+GccRateController::Signal
+GccRateController::Detect (const RateFeedback &feedback)
+{
+	double now = feedback.now.GetSeconds () * 1000;
+	double delay = feedback.delay.GetSeconds () * 1000;
+	m_smoothedDelay = m_sampleCount == 0 ? delay : 0.9 * m_smoothedDelay + 0.1 * delay;
+	m_sampleCount++;
+	m_samples.push_back (std::make_pair (now, m_smoothedDelay));
+	if (m_samples.size () > m_window)
+		m_samples.pop_front ();
+	if (m_samples.size () < 2)
+		return NORMAL;
+
+	// least-squares slope of delay over time
+	double meanX = 0;
+	double meanY = 0;
+	for (uint32_t i = 0; i < m_samples.size (); i++)
+	{
+		meanX += m_samples[i].first;
+		meanY += m_samples[i].second;
+	}
+	meanX /= m_samples.size ();
+	meanY /= m_samples.size ();
+	double num = 0;
+	double den = 0;
+	for (uint32_t i = 0; i < m_samples.size (); i++)
+	{
+		num += (m_samples[i].first - meanX) * (m_samples[i].second - meanY);
+		den += (m_samples[i].first - meanX) * (m_samples[i].first - meanX);
+	}
+	double slope = den > 0 ? num / den : 0;
+	double trend = std::min<uint32_t> (m_sampleCount, 60) * slope * 4;
+
+	// the threshold drops quickly toward a small trend and rises slowly
+	// toward a large one; reports are sparser than packet groups, so the
+	// step is capped to stay a filter
+	double dt = std::min (100.0, (feedback.now - m_lastUpdate).GetSeconds () * 1000);
+	if (std::fabs (trend) < m_threshold + 15)
+	{
+		double k = std::fabs (trend) < m_threshold ? 0.039 : 0.0087;
+		m_threshold += std::min (1.0, k * dt) * (std::fabs (trend) - m_threshold);
+		m_threshold = std::min (600.0, std::max (6.0, m_threshold));
+	}
+
+	Signal signal = NORMAL;
+	if (trend > m_threshold && trend >= m_prevTrend)
+		signal = OVERUSE;
+	else if (trend < -m_threshold)
+		signal = UNDERUSE;
+	m_prevTrend = trend;
+	return signal;
+}
+
+double
+GccRateController::DoUpdate (const RateFeedback &feedback, double rate)
+{
+	if (!m_started)
+	{
+		m_delayRate = rate;
+		m_lossRate = rate;
+		m_lastUpdate = feedback.now;
+		m_started = true;
+	}
+
+	Signal signal = Detect (feedback);
+	double elapsed = (feedback.now - m_lastUpdate).GetSeconds ();
+	m_lastUpdate = feedback.now;
+	double receiveRate = feedback.receiveRate.GetBitRate ();
+
+	switch (signal)
+	{
+		case OVERUSE: m_state = DECREASE; break;
+		case UNDERUSE: m_state = HOLD; break;
+		case NORMAL: m_state = (m_state == DECREASE) ? HOLD : INCREASE; break;
+	}
+
+	if (m_state == INCREASE)
+	{
+		m_delayRate *= std::pow (1 + m_increaseRate, std::min (elapsed, 1.0));
+		// do not run far ahead of what the path actually delivers
+		if (receiveRate > 0)
+			m_delayRate = std::min (m_delayRate, 1.5 * receiveRate);
+	}
+	else if (m_state == DECREASE)
+	{
+		NS_LOG_LOGIC ("Overuse, delay trend above " << m_threshold);
+		m_delayRate = m_beta * (receiveRate > 0 ? receiveRate : m_delayRate);
+		m_state = HOLD;
+	}
+
+	if (feedback.lossFraction > 0.1)
+		m_lossRate *= 1 - 0.5 * feedback.lossFraction;
+	else if (feedback.lossFraction < 0.02)
+		m_lossRate *= 1.05;
+	// keep both estimates in range so neither has to climb back from far outside
+	double lo = m_minRate.GetBitRate ();
+	double hi = m_maxRate.GetBitRate ();
+	m_lossRate = std::min (hi, std::max (lo, m_lossRate));
+	m_delayRate = std::min (hi, std::max (lo, m_delayRate));
+
+	return std::min (m_delayRate, m_lossRate);
+}
+
+}
@@ -0,0 +1,118 @@
+#ifndef RATE_CONTROLLER_H
+#define RATE_CONTROLLER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/traced-value.h"
+
+#include <deque>
+
+namespace ns3 {
+
+// What one receiver report tells the sender about its stream.
+struct RateFeedback
+{
+	Time now;
+	// share of data packets lost since the previous report, 0..1
+	double lossFraction;
+	DataRate receiveRate;
+	// mean one-way delay since the previous report
+	Time delay;
+	Time rtt;
+};
+
+// Sender-side congestion control for one stream. StreamingStreamer creates
+// one per session from its RateController attribute, feeds it every
+// receiver report and keeps the session's new-frame bytes under GetRate.
+class StreamingRateController : public Object
+{
+public:
+	static TypeId GetTypeId (void);
+
+	StreamingRateController ();
+	virtual ~StreamingRateController ();
+
+	void Update (const RateFeedback &feedback);
+	DataRate GetRate (void) const;
+
+protected:
+	virtual void NotifyConstructionCompleted (void);
+	// returns the new send rate in bit/s; the caller clamps it to
+	// [MinRate, MaxRate]
+	virtual double DoUpdate (const RateFeedback &feedback, double rate) = 0;
+
+	DataRate m_minRate;
+	DataRate m_maxRate;
+
+private:
+	DataRate m_initialRate;
+	TracedValue<uint64_t> m_rate;
+};
+
+// Loss-driven AIMD: the rate grows by AdditiveIncrease per second while
+// the reported loss stays under LossThreshold, and is cut by
+// DecreaseFactor at most once per round trip when it does not.
+class AimdRateController : public StreamingRateController
+{
+public:
+	static TypeId GetTypeId (void);
+
+	AimdRateController ();
+	virtual ~AimdRateController ();
+
+protected:
+	virtual double DoUpdate (const RateFeedback &feedback, double rate);
+
+private:
+	DataRate m_increase;
+	double m_decrease;
+	double m_lossThreshold;
+	Time m_lastUpdate;
+	Time m_lastDecrease;
+};
+
+// Delay-gradient control after Google Congestion Control. A trendline
+// over the reported one-way delays is compared with an adaptive threshold
+// to detect overuse; overuse cuts the rate to Beta times the receive
+// rate, normal use grows it by IncreaseRate per second, capped at 1.5x
+// the receive rate. A loss-based rate (cut above 10% loss, +5% below 2%)
+// bounds the result from above.
+class GccRateController : public StreamingRateController
+{
+public:
+	static TypeId GetTypeId (void);
+
+	GccRateController ();
+	virtual ~GccRateController ();
+
+protected:
+	virtual double DoUpdate (const RateFeedback &feedback, double rate);
+
+private:
+	enum Signal { NORMAL, OVERUSE, UNDERUSE };
+	enum State { HOLD, INCREASE, DECREASE };
+
+	Signal Detect (const RateFeedback &feedback);
+
+	double m_beta;
+	double m_increaseRate;
+	uint32_t m_window;
+
+	// trendline over (arrival ms, smoothed delay ms)
+	std::deque<std::pair<double, double> > m_samples;
+	double m_smoothedDelay;
+	uint32_t m_sampleCount;
+	double m_threshold;
+	double m_prevTrend;
+	Time m_lastUpdate;
+
+	State m_state;
+	double m_delayRate;
+	double m_lossRate;
+	bool m_started;
+};
+
+}
+
+#endif
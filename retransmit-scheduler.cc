@@ -0,0 +1,74 @@
+#include "retransmit-scheduler.h"
+
+namespace ns3 {
+
+RetransmitScheduler::RetransmitScheduler ()
+	: m_holdOff (Seconds (0)),
+	  m_dropped (0)
+{
+}
+
+void
+RetransmitScheduler::SetHoldOff (Time holdOff)
+{
+	m_holdOff = holdOff;
+}
+
+bool
+RetransmitScheduler::Enqueue (uint32_t seq, Time now)
+{
+	std::map<uint32_t, Time>::const_iterator sent = m_lastSent.find (seq);
+	if (sent != m_lastSent.end () && now - sent->second < m_holdOff)
+		return false;
+
+	if (!m_pending.insert (seq).second)
+		return false;
+
+	m_order.push (seq);
+	return true;
+}
+
+bool
+RetransmitScheduler::Dequeue (uint32_t &seq, Time now)
+{
+	if (m_order.empty ())
+		return false;
+
+	seq = m_order.top ();
+	m_order.pop ();
+	m_pending.erase (seq);
+	m_lastSent[seq] = now;
+	return true;
+}
+
+void
+RetransmitScheduler::DropBelow (uint32_t seq)
+{
+	while (!m_order.empty () && m_order.top () < seq)
+	{
+		m_pending.erase (m_order.top ());
+		m_order.pop ();
+		m_dropped++;
+	}
+	m_lastSent.erase (m_lastSent.begin (), m_lastSent.lower_bound (seq));
+}
+
+bool
+RetransmitScheduler::IsEmpty (void) const
+{
+	return m_order.empty ();
+}
+
+uint32_t
+RetransmitScheduler::GetSize (void) const
+{
+	return m_order.size ();
+}
+
+uint64_t
+RetransmitScheduler::GetDropped (void) const
+{
+	return m_dropped;
+}
+
+}
@@ -0,0 +1,47 @@
+#ifndef RETRANSMIT_SCHEDULER_H
+#define RETRANSMIT_SCHEDULER_H
+
+#include "ns3/nstime.h"
+
+#include <stdint.h>
+#include <map>
+#include <queue>
+#include <unordered_set>
+#include <vector>
+
+namespace ns3 {
+
+// Pending retransmissions keyed by sequence number.
+// Sequence order is playout order, so the smallest pending sequence is
+// always the one with the earliest deadline. Each sequence is queued at
+// most once, and a sequence that was just resent is not queued again
+// until the hold-off has passed, so repeated NACKs for a packet that is
+// already in flight do not cost extra airtime.
+class RetransmitScheduler
+{
+public:
+	RetransmitScheduler ();
+
+	void SetHoldOff (Time holdOff);
+
+	bool Enqueue (uint32_t seq, Time now);
+	bool Dequeue (uint32_t &seq, Time now);
+	// Drops every pending or remembered sequence below seq; their frames
+	// can no longer be played out in time.
+	void DropBelow (uint32_t seq);
+
+	bool IsEmpty (void) const;
+	uint32_t GetSize (void) const;
+	uint64_t GetDropped (void) const;
+
+private:
+	std::unordered_set<uint32_t> m_pending;
+	std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t> > m_order;
+	std::map<uint32_t, Time> m_lastSent;
+	Time m_holdOff;
+	uint64_t m_dropped;
+};
+
+}
+
+#endif
@@ -0,0 +1,134 @@
+#include "sequence-range-set.h"
+
+namespace ns3 {
+
+SequenceRangeSet::SequenceRangeSet ()
+	: m_count (0)
+{
+}
+
+void
+SequenceRangeSet::AddRange (uint32_t start, uint32_t end)
+{
+	if (start >= end)
+		return;
+
+	// merge with a range that ends at or after start
+	std::map<uint32_t, uint32_t>::iterator iter = m_ranges.upper_bound (start);
+	if (iter != m_ranges.begin ())
+	{
+		std::map<uint32_t, uint32_t>::iterator prev = iter;
+		--prev;
+		if (prev->second >= start)
+		{
+			if (prev->second >= end)
+				return;
+			start = prev->first;
+			m_count -= prev->second - prev->first;
+			if (end < prev->second)
+				end = prev->second;
+			m_ranges.erase (prev);
+		}
+	}
+
+	// absorb every range that starts inside [start, end]
+	iter = m_ranges.lower_bound (start);
+	while (iter != m_ranges.end () && iter->first <= end)
+	{
+		if (iter->second > end)
+			end = iter->second;
+		m_count -= iter->second - iter->first;
+		m_ranges.erase (iter++);
+	}
+
+	m_ranges.insert (std::make_pair (start, end));
+	m_count += end - start;
+}
+
+bool
+SequenceRangeSet::Remove (uint32_t seq)
+{
+	std::map<uint32_t, uint32_t>::iterator iter = m_ranges.upper_bound (seq);
+	if (iter == m_ranges.begin ())
+		return false;
+	--iter;
+	if (seq >= iter->second)
+		return false;
+
+	uint32_t start = iter->first;
+	uint32_t end = iter->second;
+	m_ranges.erase (iter);
+	if (start < seq)
+		m_ranges.insert (std::make_pair (start, seq));
+	if (seq + 1 < end)
+		m_ranges.insert (std::make_pair (seq + 1, end));
+	m_count--;
+	return true;
+}
+
+void
+SequenceRangeSet::RemoveBelow (uint32_t seq)
+{
+	while (!m_ranges.empty () && m_ranges.begin ()->first < seq)
+	{
+		std::map<uint32_t, uint32_t>::iterator iter = m_ranges.begin ();
+		uint32_t end = iter->second;
+		m_count -= end - iter->first;
+		m_ranges.erase (iter);
+		if (end > seq)
+		{
+			m_ranges.insert (std::make_pair (seq, end));
+			m_count += end - seq;
+			break;
+		}
+	}
+}
+
+bool
+SequenceRangeSet::Contains (uint32_t seq) const
+{
+	Iterator iter = m_ranges.upper_bound (seq);
+	if (iter == m_ranges.begin ())
+		return false;
+	--iter;
+	return seq < iter->second;
+}
+
+void
+SequenceRangeSet::Clear (void)
+{
+	m_ranges.clear ();
+	m_count = 0;
+}
+
+bool
+SequenceRangeSet::IsEmpty (void) const
+{
+	return m_ranges.empty ();
+}
+
+uint32_t
+SequenceRangeSet::GetRangeCount (void) const
+{
+	return m_ranges.size ();
+}
+
+uint64_t
+SequenceRangeSet::GetCount (void) const
+{
+	return m_count;
+}
+
+SequenceRangeSet::Iterator
+SequenceRangeSet::Begin (void) const
+{
+	return m_ranges.begin ();
+}
+
+SequenceRangeSet::Iterator
+SequenceRangeSet::End (void) const
+{
+	return m_ranges.end ();
+}
+
+}
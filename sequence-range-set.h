@@ -0,0 +1,39 @@
+#ifndef SEQUENCE_RANGE_SET_H
+#define SEQUENCE_RANGE_SET_H
+
+#include <stdint.h>
+#include <map>
+
+namespace ns3 {
+
+// Sorted set of disjoint half-open sequence ranges [start, end).
+// Used by the client to track outstanding losses: a burst is one node,
+// and insert, fill and prune are O(log n) in the number of ranges.
+class SequenceRangeSet
+{
+public:
+	typedef std::map<uint32_t, uint32_t>::const_iterator Iterator;
+
+	SequenceRangeSet ();
+
+	void AddRange (uint32_t start, uint32_t end);
+	bool Remove (uint32_t seq);
+	void RemoveBelow (uint32_t seq);
+	bool Contains (uint32_t seq) const;
+	void Clear (void);
+
+	bool IsEmpty (void) const;
+	uint32_t GetRangeCount (void) const;
+	uint64_t GetCount (void) const;
+
+	Iterator Begin (void) const;
+	Iterator End (void) const;
+
+private:
+	std::map<uint32_t, uint32_t> m_ranges;
+	uint64_t m_count;
+};
+
+}
+
+#endif
@@ -0,0 +1,114 @@
+#include "stream-framer.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (StreamLengthHeader);
+
+StreamLengthHeader::StreamLengthHeader ()
+	: m_length (0)
+{
+}
+
+StreamLengthHeader::~StreamLengthHeader ()
+{
+}
+
+TypeId
+StreamLengthHeader::GetTypeId (void)
+{
+	static TypeId tid = TypeId ("ns3::StreamLengthHeader")
+		.SetParent<Header> ()
+		.AddConstructor<StreamLengthHeader> ()
+		;
+	return tid;
+}
+
+TypeId
+StreamLengthHeader::GetInstanceTypeId (void) const
+{
+	return GetTypeId ();
+}
+
+void
+StreamLengthHeader::Print (std::ostream &os) const
+{
+	os << "length=" << m_length;
+}
+
+uint32_t
+StreamLengthHeader::GetSerializedSize (void) const
+{
+	return 4;
+}
+
+void
+StreamLengthHeader::Serialize (Buffer::Iterator start) const
+{
+	start.WriteHtonU32 (m_length);
+}
+
+uint32_t
+StreamLengthHeader::Deserialize (Buffer::Iterator start)
+{
+	m_length = start.ReadNtohU32 ();
+	return GetSerializedSize ();
+}
+
+void
+StreamLengthHeader::SetLength (uint32_t length)
+{
+	m_length = length;
+}
+
+uint32_t
+StreamLengthHeader::GetLength (void) const
+{
+	return m_length;
+}
+
+StreamFramer::StreamFramer ()
+{
+	m_pending = 0;
+}
+
+void
+StreamFramer::AddLength (Ptr<Packet> message)
+{
+	StreamLengthHeader header;
+	header.SetLength (message->GetSize ());
+	message->AddHeader (header);
+}
+
+void
+StreamFramer::Push (Ptr<Packet> data)
+{
+	if (m_pending == 0 || m_pending->GetSize () == 0)
+		m_pending = data;
+	else
+		m_pending->AddAtEnd (data);
+}
+
+Ptr<Packet>
+StreamFramer::Pop (void)
+{
+	StreamLengthHeader header;
+	if (m_pending == 0 || m_pending->GetSize () < header.GetSerializedSize ())
+		return 0;
+
+	m_pending->PeekHeader (header);
+	uint32_t total = header.GetSerializedSize () + header.GetLength ();
+	if (m_pending->GetSize () < total)
+		return 0;
+
+	Ptr<Packet> message = m_pending->CreateFragment (header.GetSerializedSize (), header.GetLength ());
+	m_pending->RemoveAtStart (total);
+	return message;
+}
+
+uint32_t
+StreamFramer::GetBufferedBytes (void) const
+{
+	return m_pending == 0 ? 0 : m_pending->GetSize ();
+}
+
+}
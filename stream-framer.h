@@ -0,0 +1,55 @@
+#ifndef STREAM_FRAMER_H
+#define STREAM_FRAMER_H
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/header.h"
+
+namespace ns3 {
+
+// 4-byte length prefix that delimits one message on a TCP byte stream.
+class StreamLengthHeader : public Header
+{
+public:
+	StreamLengthHeader ();
+	virtual ~StreamLengthHeader ();
+
+	void SetLength (uint32_t length);
+	uint32_t GetLength (void) const;
+
+	static TypeId GetTypeId (void);
+	virtual TypeId GetInstanceTypeId (void) const;
+	virtual void Print (std::ostream &os) const;
+	virtual void Serialize (Buffer::Iterator start) const;
+	virtual uint32_t Deserialize (Buffer::Iterator start);
+	virtual uint32_t GetSerializedSize (void) const;
+
+private:
+	uint32_t m_length;
+};
+
+// Message framing for the TCP transport. The sender prefixes every
+// message (a data packet with its SeqTs and frame headers, or a receiver
+// report) with its length; the receiver pushes whatever the socket
+// returns and pops whole messages. Segments that end on a message
+// boundary are never copied: a message is a copy-on-write fragment of
+// the received packet, and only a partial tail is appended to.
+class StreamFramer
+{
+public:
+	StreamFramer ();
+
+	static void AddLength (Ptr<Packet> message);
+
+	void Push (Ptr<Packet> data);
+	// the next whole message, or 0 while it is still incomplete
+	Ptr<Packet> Pop (void);
+	uint32_t GetBufferedBytes (void) const;
+
+private:
+	Ptr<Packet> m_pending;
+};
+
+}
+
+#endif
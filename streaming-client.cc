@@ -5,17 +5,24 @@
 #include "ns3/inet-socket-address.h"
 #include "ns3/socket.h"
 #include "ns3/udp-socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/tcp-socket-factory.h"
 #include "ns3/simulator.h"
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
 #include "ns3/seq-ts-header.h"
 #include "ns3/double.h"
+#include "ns3/string.h"
 #include "ns3/boolean.h"
-#include <random>
+#include "ns3/trace-source-accessor.h"
+#include "ns3/pointer.h"
+#include "ns3/error-model.h"
 
 #include <algorithm>
+#include <cmath>
 #include "client-header.h"
+#include "frame-header.h"
 #include "streaming-client.h"
 
 namespace ns3 {
@@ -40,6 +47,21 @@ StreamingClient::GetTypeId (void)
                    AddressValue (),
                    MakeAddressAccessor (&StreamingClient::m_peerAddress),
                    MakeAddressChecker ())
+    .AddAttribute ("Protocol", 
+                   "Socket factory for the stream: ns3::UdpSocketFactory or ns3::TcpSocketFactory",
+                   TypeIdValue (UdpSocketFactory::GetTypeId ()),
+                   MakeTypeIdAccessor (&StreamingClient::m_tid),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("MulticastGroup", 
+                   "Multicast group to join for the stream; feedback still goes to RemoteAddress",
+                   AddressValue (),
+                   MakeAddressAccessor (&StreamingClient::m_local),
+                   MakeAddressChecker ())
+    .AddAttribute ("ReceiveErrorModel", 
+                   "Error model applied to received data datagrams (UDP only); unset loses nothing here",
+                   PointerValue (),
+                   MakePointerAccessor (&StreamingClient::m_errorModel),
+                   MakePointerChecker<ErrorModel> ())
     .AddAttribute ("PacketSize", 
                    "The packet size",
 									 UintegerValue (100),
@@ -51,12 +73,12 @@ StreamingClient::GetTypeId (void)
 									 MakeUintegerAccessor (&StreamingClient::m_bufferSize),
 									 MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("PauseSize", 
-                   "The pause size for the frame buffer",
+                   "Credit window: frames past the playout frame the streamer may send",
 									 UintegerValue (30),
 									 MakeUintegerAccessor (&StreamingClient::m_pause),
 									 MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("ResumeSize", 
-                   "The resume size for the frame buffer",
+                   "Buffer level adaptive bitrate treats as low; AdaptiveBuffering adapts it",
 									 UintegerValue (5),
 									 MakeUintegerAccessor (&StreamingClient::m_resume),
 									 MakeUintegerChecker<uint32_t> ())
@@ -70,21 +92,133 @@ StreamingClient::GetTypeId (void)
                    DoubleValue (1.1),
                    MakeDoubleAccessor (&StreamingClient::m_consumeTime),
                    MakeDoubleChecker<double> ())
-    .AddAttribute ("PacketLossEnable", 
-                   "Forced Packet Loss on/off",
-                   BooleanValue (false),
-                   MakeBooleanAccessor (&StreamingClient::m_lossEnable),
-                   MakeBooleanChecker ())
-    .AddAttribute ("ErrorRate", 
-                   "ErrorRate",
-                   DoubleValue (0.01),
-                   MakeDoubleAccessor (&StreamingClient::m_errorRate),
-                   MakeDoubleChecker<double> ())
 	.AddAttribute ("Buffering", 
                    "Buffering",
                    UintegerValue(15),
                    MakeUintegerAccessor (&StreamingClient::m_buffering),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("AdaptivePlayout", 
+                   "Slow playout down when the buffer runs low and speed it up when it is deep",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&StreamingClient::m_adaptivePlayout),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PlayoutSlowdown", 
+                   "Largest playout slowdown, reached at an empty buffer (0.25 = 25% slower)",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&StreamingClient::m_playoutSlowdown),
+                   MakeDoubleChecker<double> (0.0, 0.9))
+    .AddAttribute ("PlayoutSpeedup", 
+                   "Largest playout speedup, reached at a full buffer (0.1 = 10% faster)",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&StreamingClient::m_playoutSpeedup),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("PlayoutLowFrames", 
+                   "Buffer level below which adaptive playout slows down; AdaptiveBuffering moves it with the low watermark",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&StreamingClient::m_playoutLow),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("PlayoutHighFrames", 
+                   "Buffer level above which adaptive playout speeds up",
+                   UintegerValue (30),
+                   MakeUintegerAccessor (&StreamingClient::m_playoutHigh),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("AdaptiveBuffering", 
+                   "Size the Buffering, PauseSize and ResumeSize thresholds from measured network conditions",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&StreamingClient::m_adaptiveBuffering),
+                   MakeBooleanChecker ())
+    .AddAttribute ("StallTarget", 
+                   "Fraction of playout ticks adaptive buffering allows to stall",
+                   DoubleValue (0.01),
+                   MakeDoubleAccessor (&StreamingClient::m_stallTarget),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("AdaptiveBufferMin", 
+                   "Smallest threshold adaptive buffering may choose, in frames",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&StreamingClient::m_bufferMin),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("CreditUpdateFrames", 
+                   "Frames the credit limit must advance before a credit update is sent",
+                   UintegerValue (5),
+                   MakeUintegerAccessor (&StreamingClient::m_creditStep),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("ReportInterval", 
+                   "Receiver report period when nothing has changed",
+                   TimeValue (Seconds (0.5)),
+                   MakeTimeAccessor (&StreamingClient::m_reportInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("ReportMinInterval", 
+                   "Minimum spacing of receiver reports; changes within it are coalesced",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&StreamingClient::m_reportMinInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("NackInterval", 
+                   "Receiver report period while losses are outstanding",
+                   TimeValue (MilliSeconds (50)),
+                   MakeTimeAccessor (&StreamingClient::m_nackInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("QualityLevels", 
+                   "Comma-separated packets-per-frame ladder for adaptive bitrate; empty disables ABR",
+                   StringValue (""),
+                   MakeStringAccessor (&StreamingClient::m_qualityLevels),
+                   MakeStringChecker ())
+    .AddAttribute ("StreamingFPS", 
+                   "Frame rate of the stream, used to turn a quality level into a bitrate",
+                   DoubleValue (90),
+                   MakeDoubleAccessor (&StreamingClient::m_streamFps),
+                   MakeDoubleChecker<double> ())
+    .AddTraceSource ("FrameComplete",
+                     "A frame has all of its packets",
+                     MakeTraceSourceAccessor (&StreamingClient::m_frameCompleteTrace),
+                     "ns3::StreamingClient::FrameTracedCallback")
+    .AddTraceSource ("FrameConsumed",
+                     "A frame was played out",
+                     MakeTraceSourceAccessor (&StreamingClient::m_frameConsumedTrace),
+                     "ns3::StreamingClient::FrameTracedCallback")
+    .AddTraceSource ("FrameSkipped",
+                     "An incomplete frame was passed over while later frames were ready",
+                     MakeTraceSourceAccessor (&StreamingClient::m_frameSkippedTrace),
+                     "ns3::StreamingClient::FrameTracedCallback")
+    .AddTraceSource ("StallStart",
+                     "Playback ran out of frames; carries the frame it stalled on",
+                     MakeTraceSourceAccessor (&StreamingClient::m_stallStartTrace),
+                     "ns3::StreamingClient::FrameTracedCallback")
+    .AddTraceSource ("StallEnd",
+                     "Playback resumed; carries the stall duration",
+                     MakeTraceSourceAccessor (&StreamingClient::m_stallEndTrace),
+                     "ns3::StreamingClient::StallTracedCallback")
+    .AddTraceSource ("BufferLevel",
+                     "Frames buffered after each playout tick",
+                     MakeTraceSourceAccessor (&StreamingClient::m_bufferLevelTrace),
+                     "ns3::StreamingClient::CountTracedCallback")
+    .AddTraceSource ("PlayoutRate",
+                     "Playout speed chosen for the next tick, 1 being nominal",
+                     MakeTraceSourceAccessor (&StreamingClient::m_playoutRateTrace),
+                     "ns3::StreamingClient::RateTracedCallback")
+    .AddTraceSource ("PacketDelay",
+                     "One-way delay of a received data packet",
+                     MakeTraceSourceAccessor (&StreamingClient::m_packetDelayTrace),
+                     "ns3::StreamingClient::DelayTracedCallback")
+    .AddTraceSource ("Jitter",
+                     "RFC 3550 interarrival jitter after each received packet",
+                     MakeTraceSourceAccessor (&StreamingClient::m_jitterTrace),
+                     "ns3::StreamingClient::DelayTracedCallback")
+    .AddTraceSource ("FrameSpread",
+                     "Time from the first to the last packet of a completed frame",
+                     MakeTraceSourceAccessor (&StreamingClient::m_frameSpreadTrace),
+                     "ns3::StreamingClient::DelayTracedCallback")
+    .AddTraceSource ("NackSent",
+                     "A receiver report requested this many sequences",
+                     MakeTraceSourceAccessor (&StreamingClient::m_nackSentTrace),
+                     "ns3::StreamingClient::CountTracedCallback")
+    .AddTraceSource ("LossDetected",
+                     "A sequence gap of this many packets was found and queued for NACK",
+                     MakeTraceSourceAccessor (&StreamingClient::m_lossDetectedTrace),
+                     "ns3::StreamingClient::CountTracedCallback")
+    .AddTraceSource ("Goodput",
+                     "Received bit rate over the last throughput interval",
+                     MakeTraceSourceAccessor (&StreamingClient::m_goodputTrace),
+                     "ns3::StreamingClient::RateTracedCallback")
 		;
 	return tid;
 }
@@ -93,10 +227,33 @@ StreamingClient::StreamingClient ()
 {
 	NS_LOG_FUNCTION (this);
 	m_seqNumber = 0;
+	m_tcp = false;
 	m_consumEvent = EventId ();
-	m_genEvent = EventId ();
+	m_reportEvent = EventId ();
+	m_reportBytes = 0;
+	m_reportsSent = 0;
+	m_reportSize = 0;
+	m_reportSeqBase = 0;
+	m_reportPackets = 0;
+	m_reportDelay = Seconds (0);
+	m_reportDelayCount = 0;
+	m_advertisedLimit = 0;
 	m_frameCnt = 0;
 	m_frameIdx = 0;
+	m_stalled = false;
+	m_playoutSeq = 0;
+	m_fecRecovered = 0;
+	m_nackedLosses = 0;
+	m_lastFramePackets = 0;
+	m_transit = Seconds (0);
+	m_jitter = Seconds (0);
+	m_delaySum = Seconds (0);
+	m_delaySamples = 0;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		m_completedFrames[i] = 0;
+		m_completedBytes[i] = 0;
+	}
 	m_throughputEvent = EventId ();
 	m_bufferingEvent = EventId ();
 }
@@ -113,140 +270,120 @@ StreamingClient::FrameConsumer (void)
 	// Frame Consume
 	if (m_frameCnt >= 0)
 	{
-		if (m_frameBuffer.find (m_frameIdx) != m_frameBuffer.end() )
+		uint32_t *endSeq = m_frameBuffer.Find (m_frameIdx);
+		if (endSeq)
 		{
+			m_playoutSeq = std::max (m_playoutSeq, *endSeq);
 			m_frameCnt -= 1;
-			m_frameBuffer.erase(m_frameIdx);
+			m_frameBuffer.Erase (m_frameIdx);
 			NS_LOG_INFO("FrameConsumerLog::Consume");
-			// graph log
-			/*
-			double cond = Simulator::Now ().GetSeconds() - int(Simulator::Now ().GetSeconds());
-			if ((cond >= double(0.99)) | (cond <= double(0.51) && cond >= double(0.49)))
+			m_frameConsumedTrace (m_frameIdx);
+			if (m_stalled)
 			{
-				uint32_t now_recv = m_recv;
-				double throughput = (now_recv - prev_recv_packet) * m_packetSize * 8/ 500000.0;
-				NS_LOG_INFO(Simulator::Now ().GetSeconds () << "\t" << 1 << "\t" << m_frameCnt << "\t" << throughput);
-				prev_recv_packet = now_recv;
+				m_stalled = false;
+				m_stallEndTrace (Simulator::Now () - m_stallStart);
 			}
-			else NS_LOG_INFO(Simulator::Now ().GetSeconds () << "\t" << 1 << "\t" << m_frameCnt << "\t" << "0");
-			*/
-			// ~graph log
 		}
 		else if (m_frameCnt == 0)
 		{
+			// nothing buffered: playback stalls until a frame is ready
 			NS_LOG_INFO("FrameConsumerLog::NoConsume");
-			// graph log
-			/*
-			double cond = Simulator::Now ().GetSeconds() - int(Simulator::Now ().GetSeconds());
-			if ((cond >= double(0.99)) | (cond <= double(0.51) && cond >= double(0.49)))
+			if (!m_stalled)
 			{
-				uint32_t now_recv = m_recv;
-				double throughput = (now_recv - prev_recv_packet) * m_packetSize * 8/ 500000.0;
-				NS_LOG_INFO(Simulator::Now ().GetSeconds () << "\t" << 0 << "\t" << m_frameCnt << "\t" << throughput);
-				prev_recv_packet = now_recv;
+				m_stalled = true;
+				m_stallStart = Simulator::Now ();
+				m_stallStartTrace (m_frameIdx);
 			}
-			else NS_LOG_INFO(Simulator::Now ().GetSeconds () << "\t" << 0 << "\t" << m_frameCnt << "\t" << "0");
-			*/
-			// ~graph log
 		}
 		else
 		{
+			// later frames are ready, so this incomplete one is skipped
 			NS_LOG_INFO("FrameConsumerLog::NoConsume");
-			// graph log
-			/*
-			double cond = Simulator::Now ().GetSeconds() - int(Simulator::Now ().GetSeconds());
-			if ((cond >= double(0.99)) | (cond <= double(0.51) && cond >= double(0.49)))
-			{
-				uint32_t now_recv = m_recv;
-				double throughput = (now_recv - prev_recv_packet) * m_packetSize * 8/ 500000.0;
-				NS_LOG_INFO(Simulator::Now ().GetSeconds () << "\t" << 0 << "\t" << m_frameCnt << "\t" << throughput);
-				prev_recv_packet = now_recv;
-			}
-			else NS_LOG_INFO(Simulator::Now ().GetSeconds () << "\t" << 0 << "\t" << m_frameCnt << "\t" << "0");
-			*/
-			// ~graph log
+			m_frameSkippedTrace (m_frameIdx);
 		}
 		NS_LOG_INFO("FrameConsumerLog::RemainFrames: " << m_frameCnt);
+		m_bufferLevelTrace (m_frameCnt);
+		m_bufferController.AddPlayoutTick (m_stalled);
 	}
 	else if (m_frameCnt < 0)
 	{
 		NS_LOG_INFO("FrameCountError!");
 		exit (1);
 	}
-	m_frameIdx += 1;
-
-	// FrameBufferCheck
-	if (m_frameCnt >= (int)m_pause)
+	FrameCheck *skipped = m_pChecker.Find (m_frameIdx);
+	if (skipped)
 	{
-		Ptr<Packet> p;
-		p = Create<Packet> (m_packetSize);
-		ClientHeader header;
-		uint32_t request[100] = {0};
-		header.Set(1, m_frameIdx, request);
-		p->AddHeader (header);
-
-		Ptr<UdpSocket> udpSocket = DynamicCast<UdpSocket> (m_socket);
-		udpSocket->SendTo (p, 0, m_peerAddress);
+		m_playoutSeq = std::max (m_playoutSeq, skipped->m_firstSeq + skipped->m_packets);
 	}
-	else if (m_frameCnt <= (int)m_resume)
+	m_frameIdx += 1;
+
+	// drop assembly state and losses for frames that missed their playout slot
+	request_vector.RemoveBelow (m_playoutSeq);
+	m_pChecker.Advance (m_frameIdx);
+	m_frameBuffer.Advance (m_frameIdx);
+	AdmitDeferredFrames ();
+
+	// FrameBufferCheck: grant more frames once the window has moved enough
+	if (m_frameIdx + m_pause >= m_advertisedLimit + m_creditStep)
 	{
-		Ptr<Packet> p;
-		p = Create<Packet> (m_packetSize);
-		ClientHeader header;
-		uint32_t request[100] = {0};
-		header.Set(2, m_frameIdx, request);
-		p->AddHeader (header);
-
-		Ptr<UdpSocket> udpSocket = DynamicCast<UdpSocket> (m_socket);
-		udpSocket->SendTo (p, 0, m_peerAddress);
+		ScheduleReport ();
 	}
 
-	m_consumEvent = Simulator::Schedule ( Seconds ((double)1.0/60), &StreamingClient::FrameConsumer, this);
+	double rate = m_adaptivePlayout ? PlayoutRate () : 1.0;
+	Time tick = Seconds ((double)1.0/60/rate);
+	m_playoutTime[(int)std::floor (rate * 20 + 0.5) * 5] += tick;
+	m_playoutRateTrace (rate);
+	m_consumEvent = Simulator::Schedule (tick, &StreamingClient::FrameConsumer, this);
 }
 
-
-void 
-StreamingClient::FrameGenerator (void)
+double
+StreamingClient::PlayoutRate (void) const
 {
-	RequestRetransmit();
-	if (m_frameCnt < (int)m_bufferSize)
+	// linear in the distance past the water mark, bounded at either end
+	int frames = std::max (m_frameCnt, 0);
+	if (frames < (int)m_playoutLow)
+		return 1.0 - m_playoutSlowdown * (m_playoutLow - frames) / m_playoutLow;
+	if (frames > (int)m_playoutHigh && m_bufferSize > m_playoutHigh)
 	{
-		std::map<uint32_t,FrameCheck>::iterator iter;
+		double depth = std::min (1.0, (double)(frames - m_playoutHigh) / (m_bufferSize - m_playoutHigh));
+		return 1.0 + m_playoutSpeedup * depth;
+	}
+	return 1.0;
+}
 
-		for (iter = m_pChecker.begin(); iter != m_pChecker.end();)
-		{
-			uint32_t idx = iter->first;
 
-			if (idx < m_frameIdx)
-			{
-				m_pChecker.erase(iter++);
-			}
-			else
-			{
-				uint32_t count = 0;
-				for (uint32_t i=0; i<m_fpacketN; i++)
-				{
-					FrameCheck c = iter->second;
-					if (c.c[i] == 1)
-						count++;
-				}
-
-				if (count == m_fpacketN)
-				{
-					m_pChecker.erase(iter++);
-
-					m_frameCnt++;
-					m_frameBuffer.insert({idx, true});
-				}
-				else
-				{
-					++iter;
-				}
-			}
-		}
+void
+StreamingClient::PromoteFrame (uint32_t frameIdx, uint32_t endSeq)
+{
+	if (frameIdx < m_frameIdx || m_frameBuffer.Find (frameIdx))
+		return;
+
+	if (m_frameCnt < (int)m_bufferSize && m_deferredFrames.empty ())
+	{
+		m_frameCnt++;
+		*m_frameBuffer.Insert (frameIdx) = endSeq;
 	}
+	else
+	{
+		// buffer full: hold the frame until the consumer frees a slot
+		m_deferredFrames.insert ({frameIdx, endSeq});
+	}
+}
 
-	m_genEvent = Simulator::Schedule ( Seconds ((double)1.0/20), &StreamingClient::FrameGenerator, this);
+void
+StreamingClient::AdmitDeferredFrames (void)
+{
+	while (!m_deferredFrames.empty () && m_frameCnt < (int)m_bufferSize)
+	{
+		uint32_t idx = m_deferredFrames.begin ()->first;
+		uint32_t endSeq = m_deferredFrames.begin ()->second;
+		m_deferredFrames.erase (m_deferredFrames.begin ());
+		if (idx < m_frameIdx)
+			continue;
+
+		m_frameCnt++;
+		*m_frameBuffer.Insert (idx) = endSeq;
+	}
 }
 
 
@@ -255,10 +392,24 @@ StreamingClient::StartApplication (void)
 {
 	NS_LOG_FUNCTION (this);
 	
+	m_tcp = (m_tid == TcpSocketFactory::GetTypeId ());
+	if (m_socket == 0 && m_tcp)
+  {
+    if (addressUtils::IsMulticast (m_local))
+    {
+      NS_FATAL_ERROR ("Multicast streaming needs the UDP transport");
+    }
+    // the client opens the connection; reports sent before it is up are queued by TCP
+    m_socket = Socket::CreateSocket (GetNode (), m_tid);
+    if (m_socket->Bind () == -1)
+    {
+      NS_FATAL_ERROR ("Failed to bind socket");
+    }
+    m_socket->Connect (m_peerAddress);
+  }
 	if (m_socket == 0)
   {
-    TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
-    m_socket = Socket::CreateSocket (GetNode (), tid);
+    m_socket = Socket::CreateSocket (GetNode (), m_tid);
     InetSocketAddress local = InetSocketAddress (Ipv4Address::GetAny (), m_port);
     if (m_socket->Bind (local) == -1)
     {
@@ -279,10 +430,29 @@ StreamingClient::StartApplication (void)
     }
   }
 
+	m_pChecker.SetCapacity (m_bufferSize * 2);
+	m_frameBuffer.SetCapacity (m_bufferSize * 2);
+
+	std::vector<uint32_t> ladder = AbrController::ParseLadder (m_qualityLevels);
+	if (ladder.size () > AbrController::MAX_LEVELS)
+	{
+		NS_FATAL_ERROR ("QualityLevels has " << ladder.size () << " levels, at most " << AbrController::MAX_LEVELS << " fit the header");
+	}
+	m_abr.SetLadder (ladder);
+	m_abr.SetStreamParameters (m_packetSize, m_streamFps);
+
+	m_bufferController.SetLimits (m_bufferMin, m_bufferSize);
+	m_bufferController.SetPlayoutRate (60);
+	m_bufferController.SetStallTarget (m_stallTarget);
+	m_bufferController.SetRepairInterval (m_nackInterval.GetSeconds ());
+	m_bufferController.SetCreditStep (m_creditStep);
+
 	m_socket->SetRecvCallback (MakeCallback (&StreamingClient::HandleRead, this));
 	m_bufferingEvent = Simulator::Schedule ( Seconds (m_consumeTime), &StreamingClient::BufferingChecker, this);
 	m_throughputEvent = Simulator::Schedule ( Seconds (m_consumeTime), &StreamingClient::CalcThroughput, this);
-	FrameGenerator ();
+	// the first report doubles as the join request
+	m_lastReport = Simulator::Now ();
+	SendReport ();
 }
 
 void
@@ -295,46 +465,124 @@ StreamingClient::StopApplication ()
   }
 
 	Simulator::Cancel (m_consumEvent);
-}
+	Simulator::Cancel (m_reportEvent);
 
-void 
-StreamingClient::RequestRetransmit()
-{	
-	if (request_vector.size() > 0)
+	if (m_reportsSent > 0)
+	{
+		NS_LOG_INFO("ReportLog::Sent " << m_reportsSent << " reports, "
+			<< (double)m_reportSize / m_reportsSent << " bytes each");
+	}
+
+	if (m_delaySamples > 0)
+	{
+		NS_LOG_INFO("DelayLog::Mean one-way delay " << (m_delaySum / (int64_t)m_delaySamples).GetMilliSeconds ()
+			<< " ms, jitter " << m_jitter.GetMicroSeconds () << " us");
+	}
+
+	if (m_adaptivePlayout)
 	{
-		std::vector<uint32_t>::iterator iter;
-		for (iter=request_vector.begin();iter!=request_vector.end();)
+		std::map<int, Time>::const_iterator iter;
+		for (iter = m_playoutTime.begin (); iter != m_playoutTime.end (); ++iter)
 		{
-			if (*iter<m_frameIdx*100)
-			{
-				iter = request_vector.erase(iter);
-			}
-			else
-			{
-				iter++;
-			}
+			NS_LOG_INFO("PlayoutLog::Rate " << iter->first << "%: " << iter->second.GetSeconds () << " s");
 		}
+	}
 
-		uint32_t request[100] = {0}; 
-		uint32_t idx = 0;
-		
-		for(uint32_t i=0;i<std::min(uint32_t(request_vector.size()),uint32_t(100));i++)
+	const char types[] = "IPB";
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		if (m_completedFrames[i] > 0)
 		{
-			request[idx] = request_vector[i];
-			idx++;
+			NS_LOG_INFO("FrameLog::" << types[i] << " frames completed: " << m_completedFrames[i]
+				<< ", " << (double)m_completedBytes[i] / m_completedFrames[i] << " bytes each");
 		}
-		
-		Ptr<Packet> p;
-		p = Create<Packet> (m_packetSize);
-		ClientHeader header;
-		header.Set(0, m_frameIdx, request);
-		p->AddHeader (header);
-
-		Ptr<UdpSocket> udpSocket = DynamicCast<UdpSocket> (m_socket);
-		udpSocket->SendTo (p, 0, m_peerAddress);
+	}
+
+	if (m_fecRecovered > 0)
+	{
+		NS_LOG_INFO("FecLog::Recovered " << m_fecRecovered << " packets, "
+			<< 100.0 * m_fecRecovered / (m_fecRecovered + m_nackedLosses) << "% of losses without retransmission");
 	}
 }
 
+void
+StreamingClient::ScheduleReport (void)
+{
+	// coalesce everything that changes within the minimum spacing
+	Time delay = m_lastReport + m_reportMinInterval - Simulator::Now ();
+	if (delay.IsNegative ())
+		delay = Seconds (0);
+	if (m_reportEvent.IsRunning () && Simulator::GetDelayLeft (m_reportEvent) <= delay)
+		return;
+
+	Simulator::Cancel (m_reportEvent);
+	m_reportEvent = Simulator::Schedule (delay, &StreamingClient::SendReport, this);
+}
+
+void
+StreamingClient::SendReport (void)
+{
+	Time now = Simulator::Now ();
+
+	ClientHeader header;
+	if (m_recv == 0)
+		header.SetFlags (ClientHeader::FLAG_JOIN);
+	header.SetPlayoutFrame (m_frameIdx);
+	header.SetBufferLevel (std::max (m_frameCnt, 0));
+	header.SetCredits (m_pause);
+	header.SetQuality (m_abr.IsEnabled () ? m_abr.GetLevel () : ClientHeader::QUALITY_ANY);
+
+	Time elapsed = now - m_lastReport;
+	if (elapsed.IsStrictlyPositive ())
+		header.SetReceiveRate (m_reportBytes * 8 / elapsed.GetSeconds () / 1000);
+	// RTCP-style fraction lost; repairs can push received past expected
+	uint32_t expected = m_seqNumber - m_reportSeqBase;
+	if (expected > m_reportPackets)
+		header.SetLossFraction (std::min<uint32_t> (255, (uint64_t)(expected - m_reportPackets) * 256 / expected));
+	if (m_reportDelayCount > 0)
+		header.SetDelay ((m_reportDelay / (int64_t)m_reportDelayCount).GetMicroSeconds ());
+	if (m_recv > 0)
+		header.SetEcho (m_lastDataTs.GetMicroSeconds (), (now - m_lastDataArrival).GetMicroSeconds ());
+
+	uint32_t nacked = 0;
+	SequenceRangeSet::Iterator iter;
+	for (iter = request_vector.Begin (); iter != request_vector.End (); ++iter)
+	{
+		if (!header.AddNackRange (iter->first, iter->second - iter->first))
+			break;
+		nacked += iter->second - iter->first;
+	}
+	if (nacked > 0)
+		m_nackSentTrace (nacked);
+
+	Ptr<Packet> p = Create<Packet> ();
+	p->AddHeader (header);
+	if (m_tcp)
+	{
+		StreamFramer::AddLength (p);
+		m_socket->Send (p);
+	}
+	else
+	{
+		m_socket->SendTo (p, 0, m_peerAddress);
+	}
+
+	m_lastReport = now;
+	m_reportBytes = 0;
+	m_reportSeqBase = m_seqNumber;
+	m_reportPackets = 0;
+	m_reportDelay = Seconds (0);
+	m_reportDelayCount = 0;
+	m_reportsSent++;
+	m_reportSize += p->GetSize ();
+	m_advertisedLimit = m_frameIdx + m_pause;
+
+	Time next = m_reportInterval;
+	if (m_recv == 0 || !request_vector.IsEmpty ())
+		next = m_nackInterval;
+	m_reportEvent = Simulator::Schedule (next, &StreamingClient::SendReport, this);
+}
+
 void StreamingClient::HandleRead (Ptr<Socket> socket)
 {
 	NS_LOG_FUNCTION (this << socket);
@@ -356,77 +604,209 @@ void StreamingClient::HandleRead (Ptr<Socket> socket)
 		}
 		*/
 
-		if (m_lossEnable)
+		if (m_tcp)
 		{
-			std::random_device rd;
-      		std::mt19937 gen(rd());
-      		std::uniform_int_distribution<int> dis(0, 99);
-			if (double(dis(gen))/100.0 <= m_errorRate){
-				continue;
-			}
+			// a segment may hold several messages or part of one
+			m_framer.Push (packet);
+			Ptr<Packet> message;
+			while ((message = m_framer.Pop ()))
+				HandleData (message);
+		}
+		else if (m_errorModel != 0 && m_errorModel->IsCorrupt (packet))
+		{
+			NS_LOG_LOGIC ("Dropped by the receive error model");
+		}
+		else
+		{
+			HandleData (packet);
 		}
+	}
+}
 
-		SeqTsHeader seqTs;
-		packet->RemoveHeader (seqTs);
-		uint32_t seqNumber = seqTs.GetSeq();
-		uint32_t frameIdx = seqNumber/m_fpacketN;
-		uint32_t seqN = seqNumber - frameIdx * m_fpacketN;
+void
+StreamingClient::HandleData (Ptr<Packet> packet)
+{
+	m_reportBytes += packet->GetSize ();
+	SeqTsHeader seqTs;
+	packet->RemoveHeader (seqTs);
+	m_lastDataTs = seqTs.GetTs ();
+	m_lastDataArrival = Simulator::Now ();
+
+	// one-way delay: streamer and client share the simulator clock
+	Time transit = m_lastDataArrival - m_lastDataTs;
+	if (m_recv > 0)
+	{
+		// J += (|D| - J) / 16, D being the change in transit time
+		m_jitter += (Abs (transit - m_transit) - m_jitter) / (int64_t)16;
+	}
+	m_transit = transit;
+	m_reportDelay += transit;
+	m_reportDelayCount++;
+	m_delaySum += transit;
+	m_delaySamples++;
+	m_packetDelayTrace (transit);
+	m_jitterTrace (m_jitter);
+	FrameHeader frameHeader;
+	packet->RemoveHeader (frameHeader);
+	uint32_t seqNumber = seqTs.GetSeq();
+	m_lastFramePackets = frameHeader.GetFramePackets ();
+	uint32_t frameIdx = frameHeader.GetFrameIndex ();
+	uint32_t seqN = frameHeader.GetPacketIndex ();
+	uint32_t fecGroup = frameHeader.GetFecGroup ();
+	bool parity = frameHeader.IsParity ();
+
+	if (m_recv == 0 && addressUtils::IsMulticast (m_local))
+	{
+		// a receiver joining a running multicast stream starts at the
+		// first frame it hears instead of NACKing everything before it;
+		// a unicast stream starts at frame 0, so its early losses are repaired
+		m_frameIdx = frameIdx;
+		m_pChecker.Advance (frameIdx);
+		m_frameBuffer.Advance (frameIdx);
+		m_seqNumber = parity ? seqNumber - seqN * fecGroup : seqNumber - seqN;
+		m_playoutSeq = m_seqNumber;
+		m_reportSeqBase = m_seqNumber;
+	}
 
-		if (m_pChecker.size() < (m_bufferSize * 2 * m_fpacketN) )
+	if (m_pChecker.InWindow (frameIdx))
+	{
+		// parity packets ride outside the data sequence space
+		if (!parity)
 		{
-			if (m_seqNumber == seqNumber)
-			{	
-				m_seqNumber++;
-			}
-			else if (m_seqNumber < seqNumber)
-			{
-				for(uint32_t i=m_seqNumber;i<seqNumber;i++)
-				{
-	    			request_vector.push_back(i);
-				}
-				m_seqNumber = seqNumber + 1;
-			}
-			else
-			{
-				std::vector<uint32_t>::iterator iter;
-				for (iter=request_vector.begin();iter!=request_vector.end();)
-				{
-					if (*iter == seqNumber || *iter<m_frameIdx*100)
-					{
-						iter = request_vector.erase(iter);
-					}
-					else
-					{
-						iter++;
-					}
-				}
-			}
+			TrackSequence (seqNumber);
+			m_reportPackets++;
+		}
 
-			if (m_pChecker.find(frameIdx) != m_pChecker.end())
+		FrameCheck *check = m_pChecker.Find (frameIdx);
+		if (check == 0)
+		{
+			uint32_t firstSeq = parity ? seqNumber - seqN * fecGroup : seqNumber - seqN;
+			check = m_pChecker.Insert (frameIdx);
+			check->Reset (frameHeader.GetFramePackets (), firstSeq, fecGroup);
+			check->m_type = frameHeader.GetFrameType ();
+			check->m_bytes = frameHeader.GetFrameBytes ();
+			check->m_firstArrival = m_lastDataArrival;
+		}
+
+		uint32_t group = 0;
+		if (parity)
+		{
+			check->MarkParity (seqN);
+			group = seqN;
+		}
+		else
+		{
+			// goodput counts each data packet once: parity, duplicate
+			// retransmits and packets of frames already assembled add nothing
+			bool assembled = m_frameBuffer.Find (frameIdx) || m_deferredFrames.count (frameIdx);
+			if (check->Mark (seqN) && !assembled)
+				m_recvBytes += packet->GetSize ();
+			group = fecGroup > 0 ? seqN / fecGroup : 0;
+		}
+
+		if (fecGroup > 0 && !check->IsComplete ())
+		{
+			uint32_t lost = check->Recover (group);
+			if (lost < check->m_packets)
 			{
-				FrameCheck tc = m_pChecker[frameIdx];
-				tc.c[seqN] = 1;
-				m_pChecker[frameIdx]=tc;
+				// simulated packets carry no payload to XOR, so recovery is
+				// bookkeeping; the rebuilt payload still counts as delivered,
+				// sized like the streamer's (the frame's last packet is short)
+				uint32_t size = m_packetSize;
+				if (lost + 1 == check->m_packets && check->m_bytes > lost * m_packetSize)
+					size = std::min (m_packetSize, check->m_bytes - lost * m_packetSize);
+				m_recvBytes += size;
+				check->Mark (lost);
+				m_fecRecovered++;
+				if (request_vector.Remove (check->m_firstSeq + lost))
+					m_nackedLosses--;
+				else
+					TrackSequence (check->m_firstSeq + lost);
 			}
-			else
+		}
+
+		if (check->IsComplete ())
+		{
+			NS_LOG_LOGIC ("Frame " << frameIdx << " complete");
+			m_frameCompleteTrace (frameIdx);
+			m_frameSpreadTrace (m_lastDataArrival - check->m_firstArrival);
+			m_bufferController.AddFrameSpread ((m_lastDataArrival - check->m_firstArrival).GetSeconds ());
+			if (check->m_type < 3)
 			{
-				FrameCheck c;
-				c.c[seqN] = 1;
-				m_pChecker.insert({frameIdx,c});
+				m_completedFrames[check->m_type]++;
+				m_completedBytes[check->m_type] += check->m_bytes;
 			}
+			uint32_t endSeq = check->m_firstSeq + check->m_packets;
+			m_pChecker.Erase (frameIdx);
+			PromoteFrame (frameIdx, endSeq);
 		}
+	}
+
+	m_recv += 1;
+}
 
-		m_recv += 1;
+void
+StreamingClient::TrackSequence (uint32_t seqNumber)
+{
+	if (m_seqNumber == seqNumber)
+	{	
+		m_seqNumber++;
+	}
+	else if (m_seqNumber < seqNumber)
+	{
+		request_vector.AddRange (m_seqNumber, seqNumber);
+		m_nackedLosses += seqNumber - m_seqNumber;
+		m_lossDetectedTrace (seqNumber - m_seqNumber);
+		m_bufferController.AddLossBurst (seqNumber - m_seqNumber, m_lastFramePackets);
+		m_seqNumber = seqNumber + 1;
+		ScheduleReport ();
+	}
+	else
+	{
+		request_vector.Remove (seqNumber);
 	}
 }
 
 void StreamingClient::CalcThroughput()
 {
-	// If you want to print out throughput, enable under codes.
-	uint32_t now_recv = m_recv;
-	// double throughput = (now_recv - prev_recv_packet) * m_packetSize * 8/ 500000.0;
-	// NS_LOG_INFO(Simulator::Now ().GetSeconds () << "\t" << throughput);
-	prev_recv_packet = now_recv;
+	uint64_t now_recv = m_recvBytes;
+	double throughput = (now_recv - prev_recv_bytes) * 8 / 0.5;
+	prev_recv_bytes = now_recv;
+	m_goodputTrace (throughput);
+
+	if (m_adaptiveBuffering)
+	{
+		m_bufferController.AddThroughput (throughput);
+		m_bufferController.Update (m_transit.GetSeconds (), m_jitter.GetSeconds ());
+		uint32_t credit = m_bufferController.GetCreditFrames ();
+		if (m_resume != m_bufferController.GetLowFrames () || m_pause != credit
+			|| m_buffering != m_bufferController.GetStartupFrames ())
+		{
+			NS_LOG_INFO("BufferLog::Low " << m_bufferController.GetLowFrames ()
+				<< " startup " << m_bufferController.GetStartupFrames () << " credit " << credit
+				<< " safety " << m_bufferController.GetSafety ());
+			// a larger window is worth telling the streamer now
+			if (credit > m_pause)
+				ScheduleReport ();
+			m_resume = m_bufferController.GetLowFrames ();
+			m_buffering = m_bufferController.GetStartupFrames ();
+			m_pause = credit;
+			// playout starts slowing down at the measured low watermark
+			m_playoutLow = m_resume;
+		}
+	}
+
+	if (m_abr.IsEnabled ())
+	{
+		uint8_t prev = m_abr.GetLevel ();
+		uint8_t level = m_abr.Update (throughput, std::max (m_frameCnt, 0), m_resume, m_pause);
+		if (level != prev)
+		{
+			NS_LOG_INFO("AbrLog::Quality: " << (uint32_t)level << " (" << m_abr.GetFramePackets (level) << " packets/frame)");
+			ScheduleReport ();
+		}
+	}
+
 	m_throughputEvent = Simulator::Schedule ( Seconds (0.5), &StreamingClient::CalcThroughput, this);
 }
 
@@ -444,12 +824,89 @@ void StreamingClient::BufferingChecker()
 
 FrameCheck::FrameCheck ()
 {
-	for (uint32_t i=0; i<100; i++)
-		c[i] = 0;
+	m_packets = 0;
+	m_received = 0;
+	m_firstSeq = 0;
+	m_fecGroup = 0;
+	m_type = 0;
+	m_bytes = 0;
 }
 
 FrameCheck::~FrameCheck()
 {
 }
 
+void
+FrameCheck::Reset (uint32_t packets, uint32_t firstSeq, uint32_t fecGroup)
+{
+	m_packets = packets;
+	m_received = 0;
+	m_firstSeq = firstSeq;
+	m_fecGroup = fecGroup;
+	m_bits.assign ((packets + 63) / 64, 0);
+	if (fecGroup > 0)
+		m_parity.assign (((packets + fecGroup - 1) / fecGroup + 63) / 64, 0);
+	else
+		m_parity.clear ();
+}
+
+bool
+FrameCheck::Mark (uint32_t seqN)
+{
+	if (seqN >= m_packets)
+		return false;
+
+	uint64_t mask = (uint64_t)1 << (seqN % 64);
+	uint64_t &word = m_bits[seqN / 64];
+	if (word & mask)
+		return false;
+
+	word |= mask;
+	m_received++;
+	return true;
+}
+
+bool
+FrameCheck::Has (uint32_t seqN) const
+{
+	if (seqN >= m_packets)
+		return false;
+	return (m_bits[seqN / 64] >> (seqN % 64)) & 1;
+}
+
+bool
+FrameCheck::IsComplete (void) const
+{
+	return m_packets > 0 && m_received == m_packets;
+}
+
+void
+FrameCheck::MarkParity (uint32_t group)
+{
+	if (group / 64 >= m_parity.size ())
+		return;
+	m_parity[group / 64] |= (uint64_t)1 << (group % 64);
+}
+
+uint32_t
+FrameCheck::Recover (uint32_t group) const
+{
+	if (group / 64 >= m_parity.size () || !((m_parity[group / 64] >> (group % 64)) & 1))
+		return m_packets;
+
+	// XOR parity rebuilds exactly one missing packet per group
+	uint32_t first = group * m_fecGroup;
+	uint32_t last = std::min (first + m_fecGroup, m_packets);
+	uint32_t lost = m_packets;
+	for (uint32_t i = first; i < last; i++)
+	{
+		if (Has (i))
+			continue;
+		if (lost != m_packets)
+			return m_packets;
+		lost = i;
+	}
+	return lost;
+}
+
 }
@@ -6,21 +6,51 @@
 #include "ns3/ptr.h"
 #include "ns3/address.h"
 #include "ns3/application-container.h"
+#include "ns3/traced-callback.h"
+#include "frame-window.h"
+#include "sequence-range-set.h"
+#include "abr-controller.h"
+#include "buffer-controller.h"
+#include "stream-framer.h"
 
 #include <map>
+#include <string>
 #include <vector>
 
+class ClientHeader;
+
 namespace ns3{
 
 class Socket;
+class ErrorModel;
 class Packet;
 
+// Per-frame assembly state: one bit per packet plus a received counter,
+// so completeness is known as soon as the last packet is marked.
 class FrameCheck
 {
 	public:
 		FrameCheck ();
 		~FrameCheck ();
-		int c[100];
+
+		void Reset (uint32_t packets, uint32_t firstSeq, uint32_t fecGroup);
+		bool Mark (uint32_t seqN);
+		bool Has (uint32_t seqN) const;
+		bool IsComplete (void) const;
+		void MarkParity (uint32_t group);
+		// packet index rebuildable from the group's parity, or m_packets
+		uint32_t Recover (uint32_t group) const;
+
+		uint32_t m_packets;
+		uint32_t m_received;
+		uint32_t m_firstSeq;
+		uint32_t m_fecGroup;
+		// FrameTrace::FrameType and encoded size from the frame header
+		uint8_t m_type;
+		uint32_t m_bytes;
+		Time m_firstArrival;
+		std::vector<uint64_t> m_bits;
+		std::vector<uint64_t> m_parity;
 };
 
 class StreamingClient : public Application
@@ -30,28 +60,39 @@ public:
 	StreamingClient ();
 	virtual ~StreamingClient ();
 
+	typedef void (* FrameTracedCallback)(uint32_t frameIdx);
+	typedef void (* StallTracedCallback)(Time duration);
+	typedef void (* CountTracedCallback)(uint32_t count);
+	typedef void (* RateTracedCallback)(double bps);
+	typedef void (* DelayTracedCallback)(Time delay);
+
 	void FrameConsumer (void);
-	void FrameGenerator (void);
 	// ==========
 	void CalcThroughput (void);
 	void BufferingChecker (void);
 	// ==========
-	std::map<uint32_t, FrameCheck> m_pChecker;
+	FrameWindow<FrameCheck> m_pChecker;
 
 private:
 	virtual void StartApplication (void);
 	virtual void StopApplication(void);
 
 	void HandleRead (Ptr<Socket> socket);
+	void HandleData (Ptr<Packet> packet);
+	void TrackSequence (uint32_t seqNumber);
 	
 	uint16_t m_port;
 	Ptr<Socket> m_socket;
 	Address m_local;
+	// socket factory; with TCP, data and reports are length-framed on one connection
+	TypeId m_tid;
+	bool m_tcp;
+	StreamFramer m_framer;
+	// drops datagrams above the MAC, where retries cannot hide the loss
+	Ptr<ErrorModel> m_errorModel;
 
 	uint32_t m_seqNumber;
 	uint32_t m_fpacketN;
-	bool m_lossEnable;
-	double m_errorRate;
 
 	// Frame Consumer
 	uint32_t m_resume;
@@ -60,26 +101,118 @@ private:
 	uint32_t m_frameIdx;
 	uint32_t m_packetSize;
 	int m_frameCnt;
-	std::map<uint32_t,bool> m_frameBuffer;
+	// buffered frames, each holding the sequence just past its last packet
+	FrameWindow<uint32_t> m_frameBuffer;
 	EventId m_consumEvent;
 	Address m_peerAddress;
 	double m_consumeTime;
 
+	// Adaptive media playout: below m_playoutLow buffered frames the tick
+	// stretches by up to m_playoutSlowdown, above m_playoutHigh it shortens
+	// by up to m_playoutSpeedup. Time spent per rate, in 5% steps, is kept
+	// for the end-of-run PlayoutLog.
+	double PlayoutRate (void) const;
+	bool m_adaptivePlayout;
+	double m_playoutSlowdown;
+	double m_playoutSpeedup;
+	uint32_t m_playoutLow;
+	uint32_t m_playoutHigh;
+	std::map<int, Time> m_playoutTime;
+	TracedCallback<double> m_playoutRateTrace;
+
 	// Throughput Test
-	uint32_t prev_recv_packet = 0;
+	uint64_t prev_recv_bytes = 0;
 	EventId m_throughputEvent;
 	uint32_t m_recv = 0;
+	// payload bytes received; frames are no longer whole packets
+	uint64_t m_recvBytes = 0;
+	// completed frames and bytes per FrameTrace::FrameType
+	uint64_t m_completedFrames[3];
+	uint64_t m_completedBytes[3];
 
 	EventId m_bufferingEvent;
 	uint32_t m_buffering;
 	// ~buffering test
 
-	// Frame Generator
-	EventId m_genEvent;
-
-	//dongwon - retransmit
-	void RequestRetransmit();
-	std::vector<uint32_t> request_vector;
+	// Frame Admission
+	void PromoteFrame (uint32_t frameIdx, uint32_t endSeq);
+	void AdmitDeferredFrames (void);
+	std::map<uint32_t, uint32_t> m_deferredFrames;
+	// every loss below this sequence belongs to an already played frame
+	uint32_t m_playoutSeq;
+
+	// Receiver reports: one message carries NACKs, credit, quality, rate
+	// and the timestamp echo. A report goes out when something new needs
+	// telling (at most one per m_reportMinInterval), every m_nackInterval
+	// while losses are outstanding or before data flows, and otherwise
+	// every m_reportInterval as a keepalive.
+	void ScheduleReport (void);
+	void SendReport (void);
+	EventId m_reportEvent;
+	Time m_reportInterval;
+	Time m_reportMinInterval;
+	Time m_nackInterval;
+	Time m_lastReport;
+	uint64_t m_reportBytes;
+	uint64_t m_reportsSent;
+	uint64_t m_reportSize;
+	// send timestamp and arrival time of the newest data packet
+	Time m_lastDataTs;
+	Time m_lastDataArrival;
+	// loss fraction and mean one-way delay since the previous report
+	uint32_t m_reportSeqBase;
+	uint32_t m_reportPackets;
+	Time m_reportDelay;
+	uint32_t m_reportDelayCount;
+
+	// latency: one-way delay from the SeqTsHeader send time, RFC 3550
+	// interarrival jitter over successive transit times, and the spread
+	// between the first and last packet of each completed frame
+	Time m_transit;
+	Time m_jitter;
+	Time m_delaySum;
+	uint64_t m_delaySamples;
+	TracedCallback<Time> m_packetDelayTrace;
+	TracedCallback<Time> m_jitterTrace;
+	TracedCallback<Time> m_frameSpreadTrace;
+
+	// credit-based flow control: the streamer may send frames below
+	// m_frameIdx + m_pause; the limit is re-advertised once it has moved
+	// by m_creditStep frames
+	uint32_t m_creditStep;
+	uint32_t m_advertisedLimit;
+
+	// Adaptive buffering: startup, credit and low thresholds follow the
+	// measured throughput variance, jitter, frame spread and loss bursts
+	bool m_adaptiveBuffering;
+	double m_stallTarget;
+	uint32_t m_bufferMin;
+	BufferController m_bufferController;
+	// packets in the newest frame heard, to size loss bursts in frames
+	uint32_t m_lastFramePackets;
+
+	// FEC
+	uint64_t m_fecRecovered;
+	uint64_t m_nackedLosses;
+
+	// Adaptive bitrate
+	AbrController m_abr;
+	std::string m_qualityLevels;
+	double m_streamFps;
+	SequenceRangeSet request_vector;
+
+	// QoE traces
+	bool m_stalled;
+	Time m_stallStart;
+	TracedCallback<uint32_t> m_frameCompleteTrace;
+	TracedCallback<uint32_t> m_frameConsumedTrace;
+	TracedCallback<uint32_t> m_frameSkippedTrace;
+	TracedCallback<uint32_t> m_stallStartTrace;
+	TracedCallback<Time> m_stallEndTrace;
+	TracedCallback<uint32_t> m_bufferLevelTrace;
+	TracedCallback<uint32_t> m_nackSentTrace;
+	TracedCallback<uint32_t> m_lossDetectedTrace;
+	TracedCallback<double> m_goodputTrace;
 };
 
 
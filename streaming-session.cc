@@ -0,0 +1,85 @@
+#include "ns3/socket.h"
+#include "streaming-session.h"
+
+namespace ns3 {
+
+StreamingSession::StreamingSession ()
+{
+	m_creditLimit = 0;
+	m_seqNumber = 0;
+	m_frameNumber = 0;
+	m_currentFrame = 0;
+	m_quality = 0;
+	m_targetQuality = 0;
+	m_bufferLevel = 0;
+	m_receiveRate = 0;
+	m_rtt = Seconds (0);
+	m_rateController = 0;
+	m_sendBudget = 0;
+	m_socket = 0;
+	m_sent = 0;
+	m_retransmitted = 0;
+}
+
+StreamingSession::~StreamingSession ()
+{
+}
+
+const StreamingSession::SentFrame&
+StreamingSession::NewFrame (uint16_t packets, uint8_t quality, uint8_t type, uint32_t bytes)
+{
+	SentFrame frame;
+	frame.frameIdx = m_frameNumber++;
+	frame.firstSeq = m_seqNumber;
+	frame.packets = packets;
+	frame.quality = quality;
+	frame.type = type;
+	frame.bytes = bytes;
+	m_history.push_back (frame);
+	m_seqNumber += packets;
+	return m_history.back ();
+}
+
+uint32_t
+StreamingSession::FrameFirstSeq (uint32_t frameIdx) const
+{
+	if (m_history.empty () || frameIdx > m_history.back ().frameIdx)
+		return m_seqNumber;
+	if (frameIdx < m_history.front ().frameIdx)
+		return m_history.front ().firstSeq;
+	return m_history[frameIdx - m_history.front ().frameIdx].firstSeq;
+}
+
+const StreamingSession::SentFrame*
+StreamingSession::FindFrame (uint32_t seq) const
+{
+	// history is ordered by firstSeq: find the last frame starting at or before seq
+	uint32_t lo = 0;
+	uint32_t hi = m_history.size ();
+	while (lo < hi)
+	{
+		uint32_t mid = (lo + hi) / 2;
+		if (m_history[mid].firstSeq <= seq)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == 0)
+		return 0;
+
+	const SentFrame &frame = m_history[lo - 1];
+	if (seq >= frame.firstSeq + frame.packets)
+		return 0;
+	return &frame;
+}
+
+void
+StreamingSession::PruneHistory (uint32_t frameIdx)
+{
+	while (!m_history.empty () && m_history.front ().frameIdx < frameIdx)
+	{
+		m_history.pop_front ();
+	}
+}
+
+}
@@ -0,0 +1,76 @@
+#ifndef STREAMING_SESSION_H
+#define STREAMING_SESSION_H
+
+#include "ns3/address.h"
+#include "ns3/ptr.h"
+#include "retransmit-scheduler.h"
+#include "rate-controller.h"
+#include "stream-framer.h"
+
+#include <deque>
+#include <utility>
+
+namespace ns3 {
+
+class Socket;
+
+// Per-viewer state kept by StreamingStreamer, keyed by the client's
+// source address: its own sequence space, credit limit, NACK queue,
+// quality level and the frames it may still play.
+class StreamingSession
+{
+	public:
+		struct SentFrame
+		{
+			uint32_t frameIdx;
+			uint32_t firstSeq;
+			uint16_t packets;
+			uint8_t quality;
+			uint8_t type;
+			uint32_t bytes;
+		};
+
+		StreamingSession ();
+		~StreamingSession ();
+
+		// appends the next frame to the history and reserves its sequences
+		const SentFrame& NewFrame (uint16_t packets, uint8_t quality, uint8_t type, uint32_t bytes);
+		const SentFrame* FindFrame (uint32_t seq) const;
+		uint32_t FrameFirstSeq (uint32_t frameIdx) const;
+		void PruneHistory (uint32_t frameIdx);
+
+		Address m_address;
+		// new frames are sent only while m_frameNumber is below this
+		uint32_t m_creditLimit;
+		uint32_t m_seqNumber;
+		uint32_t m_frameNumber;
+		uint32_t m_currentFrame;
+		uint8_t m_quality;
+		uint8_t m_targetQuality;
+		RetransmitScheduler m_retransmit;
+		// frames the client may still play, oldest first
+		std::deque<SentFrame> m_history;
+
+		// latest receiver report
+		uint32_t m_bufferLevel;
+		uint64_t m_receiveRate;
+		Time m_rtt;
+
+		// congestion control; null sends whatever the credit allows
+		Ptr<StreamingRateController> m_rateController;
+		// bytes the rate still allows this frame interval, may run negative
+		double m_sendBudget;
+
+		// TCP transport: the accepted connection, its report reassembly and
+		// framed data packets (with their sequence) waiting for send buffer
+		Ptr<Socket> m_socket;
+		StreamFramer m_framer;
+		std::deque<std::pair<uint32_t, Ptr<Packet> > > m_backlog;
+
+		uint32_t m_sent;
+		uint32_t m_retransmitted;
+};
+
+}
+
+#endif
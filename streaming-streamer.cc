@@ -5,14 +5,24 @@
 #include "ns3/socket.h"
 #include "ns3/simulator.h"
 #include "ns3/socket-factory.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/tcp-socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
 #include "ns3/seq-ts-header.h"
 #include "ns3/double.h"
 #include "ns3/boolean.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/string.h"
+#include "ns3/object-factory.h"
+#include "ns3/pointer.h"
+#include "ns3/error-model.h"
 
 #include <algorithm>
+#include <cmath>
 #include "client-header.h"
+#include "frame-header.h"
+#include "abr-controller.h"
 #include "streaming-streamer.h"
 
 namespace ns3 {
@@ -28,7 +38,7 @@ StreamingStreamer::GetTypeId (void)
 		.SetParent<Application> ()
 		.AddConstructor<StreamingStreamer> ()
     .AddAttribute ("RemoteAddress", 
-                   "The destination Address of the outbound packets",
+                   "Address of a client to stream to from the start; others join by sending feedback",
                    AddressValue (),
                    MakeAddressAccessor (&StreamingStreamer::m_peerAddress),
                    MakeAddressChecker ())
@@ -37,6 +47,31 @@ StreamingStreamer::GetTypeId (void)
                    UintegerValue (0),
                    MakeUintegerAccessor (&StreamingStreamer::m_peerPort),
                    MakeUintegerChecker<uint16_t> ())
+		.AddAttribute ("LocalPort", 
+                   "Port the streamer listens on for client feedback; 0 picks an ephemeral port",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&StreamingStreamer::m_localPort),
+                   MakeUintegerChecker<uint16_t> ())
+		.AddAttribute ("Protocol", 
+                   "Socket factory for the stream: ns3::UdpSocketFactory or ns3::TcpSocketFactory",
+                   TypeIdValue (UdpSocketFactory::GetTypeId ()),
+                   MakeTypeIdAccessor (&StreamingStreamer::m_tid),
+                   MakeTypeIdChecker ())
+		.AddAttribute ("MulticastGroup", 
+                   "Ipv4 multicast group to stream to; unset streams to each client by unicast",
+                   AddressValue (),
+                   MakeAddressAccessor (&StreamingStreamer::m_multicastGroup),
+                   MakeAddressChecker ())
+		.AddAttribute ("ReceiveErrorModel", 
+                   "Error model applied to received report datagrams (UDP only); unset loses nothing here",
+                   PointerValue (),
+                   MakePointerAccessor (&StreamingStreamer::m_errorModel),
+                   MakePointerChecker<ErrorModel> ())
+		.AddAttribute ("MulticastRepairThreshold", 
+                   "Receivers that must NACK a packet before it is repaired by multicast instead of unicast",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&StreamingStreamer::m_repairThreshold),
+                   MakeUintegerChecker<uint32_t> (1))
 		.AddAttribute ("PacketSize", "Size of echo data in outbound packets",
                    UintegerValue (100),
                    MakeUintegerAccessor (&StreamingStreamer::SetDataSize,
@@ -52,16 +87,54 @@ StreamingStreamer::GetTypeId (void)
                    UintegerValue (100),
                    MakeUintegerAccessor (&StreamingStreamer::m_fpacketN),
                    MakeUintegerChecker<uint32_t> ())
-    .AddAttribute ("PacketLossEnable", 
-                   "Forced Packet Loss on/off",
+    .AddAttribute ("QualityLevels", 
+                   "Comma-separated packets-per-frame ladder; empty sends FramePackets at a single level",
+                   StringValue (""),
+                   MakeStringAccessor (&StreamingStreamer::m_qualityLevels),
+                   MakeStringChecker ())
+    .AddAttribute ("FrameTrace", 
+                   "Per-frame type and size trace (frameNo,type,bytes CSV or ASU format); empty sends fixed FramePackets frames",
+                   StringValue (""),
+                   MakeStringAccessor (&StreamingStreamer::m_frameTracePath),
+                   MakeStringChecker ())
+    .AddAttribute ("RateController", 
+                   "StreamingRateController TypeId per session, e.g. ns3::AimdRateController or ns3::GccRateController; empty sends at the credit limit",
+                   StringValue (""),
+                   MakeStringAccessor (&StreamingStreamer::m_rateControllerType),
+                   MakeStringChecker ())
+    .AddAttribute ("FecRatio", 
+                   "Parity packets per data packet (e.g. 0.1 = one XOR parity per 10 packets); 0 disables FEC",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&StreamingStreamer::m_fecRatio),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("RetransmitLead", 
+                   "Frames ahead of the client's playout frame below which retransmits are dropped",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&StreamingStreamer::m_retransmitLead),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RetransmitHoldOff", 
+                   "Minimum time before the same sequence is retransmitted again",
+                   TimeValue (MilliSeconds (50)),
+                   MakeTimeAccessor (&StreamingStreamer::m_retransmitHoldOff),
+                   MakeTimeChecker ())
+    .AddAttribute ("PacingEnable", 
+                   "Spread packets across the frame interval instead of bursting them",
                    BooleanValue (false),
-                   MakeBooleanAccessor (&StreamingStreamer::m_lossEnable),
+                   MakeBooleanAccessor (&StreamingStreamer::m_pacing),
                    MakeBooleanChecker ())
-    .AddAttribute ("ErrorRate", 
-                   "ErrorRate",
-                   DoubleValue (0.01),
-                   MakeDoubleAccessor (&StreamingStreamer::m_errorRate),
-                   MakeDoubleChecker<double> ())
+    .AddAttribute ("PacingRate", 
+                   "Pacing rate; 0 spreads each frame evenly over the frame interval",
+                   DataRateValue (DataRate (0)),
+                   MakeDataRateAccessor (&StreamingStreamer::m_pacingRate),
+                   MakeDataRateChecker ())
+    .AddTraceSource ("PacingQueue",
+                     "Number of packets waiting in the pacing queue",
+                     MakeTraceSourceAccessor (&StreamingStreamer::m_txQueueLength),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("RetransmitSent",
+                     "A NACKed sequence was resent; the flag marks a multicast repair",
+                     MakeTraceSourceAccessor (&StreamingStreamer::m_retransmitTrace),
+                     "ns3::StreamingStreamer::RetransmitTracedCallback")
 	;
 	return tid;
 }
@@ -72,9 +145,11 @@ StreamingStreamer::StreamingStreamer ()
   m_sent = 0;
   m_socket = 0;
   m_sendEvent = EventId ();
-	m_seqNumber = 0;
-	m_pause = false;
-	currentFrame = 0;
+	m_txQueueLength = 0;
+	m_paceEvent = EventId ();
+	m_fecGroup = 0;
+	m_paritySent = 0;
+	m_multicast = false;
 }
 
 StreamingStreamer::~StreamingStreamer()
@@ -88,34 +163,74 @@ StreamingStreamer::StartApplication (void)
 {
   NS_LOG_FUNCTION (this);
 
-  if (m_socket == 0)
-  {
-    TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
-    m_socket = Socket::CreateSocket (GetNode (), tid);
-    if (Ipv4Address::IsMatchingType(m_peerAddress) == true)
-    {
-      if (m_socket->Bind () == -1)
-      {
-        NS_FATAL_ERROR ("Failed to bind socket");
-      }
-      m_socket->Connect (InetSocketAddress (Ipv4Address::ConvertFrom(m_peerAddress), m_peerPort));
-    }
-    else if (InetSocketAddress::IsMatchingType (m_peerAddress) == true)
+  m_ladder = AbrController::ParseLadder (m_qualityLevels);
+  if (m_ladder.size () > AbrController::MAX_LEVELS)
+    NS_FATAL_ERROR ("QualityLevels has " << m_ladder.size () << " levels, at most "
+                    << AbrController::MAX_LEVELS << " fit the header");
+  if (m_ladder.empty ())
+    m_ladder.push_back (m_fpacketN);
+
+  if (!m_frameTracePath.empty ())
     {
-      if (m_socket->Bind () == -1)
-      {
-        NS_FATAL_ERROR ("Failed to bind socket");
-      }
-      m_socket->Connect (m_peerAddress);
+      if (!m_frameTrace.Load (m_frameTracePath))
+        NS_FATAL_ERROR ("Cannot read frame trace " << m_frameTracePath);
+      NS_LOG_INFO ("TraceLog::" << m_frameTrace.GetFrameCount () << " frames, "
+                   << m_frameTrace.GetMeanBytes () << " bytes each on average");
     }
-    else
+
+  m_fecGroup = 0;
+  if (m_fecRatio > 0)
+    m_fecGroup = std::min (255.0, std::max (1.0, std::floor (1.0 / m_fecRatio + 0.5)));
+
+  m_tcp = (m_tid == TcpSocketFactory::GetTypeId ());
+  if (m_socket == 0)
+  {
+    m_socket = Socket::CreateSocket (GetNode (), m_tid);
+    if (m_socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), m_localPort)) == -1)
     {
-          NS_ASSERT_MSG (false, "Incompatible address type: " << m_peerAddress);
+      NS_FATAL_ERROR ("Failed to bind socket");
     }
   }
 
-  m_socket->SetRecvCallback (MakeCallback (&StreamingStreamer::HandleRead, this));
-  m_socket->SetAllowBroadcast (true);
+  m_multicast = Ipv4Address::IsMatchingType (m_multicastGroup)
+                && Ipv4Address::ConvertFrom (m_multicastGroup).IsMulticast ();
+  if (m_multicast && m_tcp)
+  {
+    NS_FATAL_ERROR ("Multicast streaming needs the UDP transport");
+  }
+  if (m_multicast)
+  {
+    m_group.m_address = InetSocketAddress (Ipv4Address::ConvertFrom (m_multicastGroup), m_peerPort);
+    m_group.m_retransmit.SetHoldOff (m_retransmitHoldOff);
+    m_group.m_quality = m_ladder.size () - 1;
+    m_group.m_targetQuality = m_group.m_quality;
+  }
+
+  if (Ipv4Address::IsMatchingType(m_peerAddress) == true)
+  {
+    GetSession (InetSocketAddress (Ipv4Address::ConvertFrom(m_peerAddress), m_peerPort));
+  }
+  else if (InetSocketAddress::IsMatchingType (m_peerAddress) == true)
+  {
+    GetSession (m_peerAddress);
+  }
+  else if (!m_peerAddress.IsInvalid ())
+  {
+    NS_ASSERT_MSG (false, "Incompatible address type: " << m_peerAddress);
+  }
+
+  if (m_tcp)
+  {
+    // each client connects in; its session is keyed by the connection's peer address
+    m_socket->Listen ();
+    m_socket->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                                 MakeCallback (&StreamingStreamer::HandleAccept, this));
+  }
+  else
+  {
+    m_socket->SetRecvCallback (MakeCallback (&StreamingStreamer::HandleRead, this));
+    m_socket->SetAllowBroadcast (true);
+  }
   ScheduleTx (Seconds (0.));
 }
 
@@ -132,6 +247,40 @@ StreamingStreamer::StopApplication ()
     }
 
   Simulator::Cancel (m_sendEvent);
+  Simulator::Cancel (m_paceEvent);
+
+  std::map<Address, StreamingSession>::iterator iter;
+  for (iter = m_sessions.begin (); iter != m_sessions.end (); ++iter)
+    {
+      StreamingSession &session = iter->second;
+      if (session.m_socket != 0)
+        {
+          session.m_socket->Close ();
+          session.m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+          session.m_socket = 0;
+        }
+      NS_LOG_INFO ("SessionLog::" << InetSocketAddress::ConvertFrom (session.m_address).GetIpv4 ()
+                   << " frames=" << session.m_frameNumber << " packets=" << session.m_sent
+                   << " retransmits=" << session.m_retransmitted
+                   << " expired=" << session.m_retransmit.GetDropped ()
+                   << " rtt=" << session.m_rtt.GetMilliSeconds () << "ms"
+                   << " rate=" << GetSendRate (session).GetBitRate () / 1e6 << "Mbps");
+    }
+
+  if (m_multicast)
+    {
+      NS_LOG_INFO ("GroupLog::" << Ipv4Address::ConvertFrom (m_multicastGroup)
+                   << " receivers=" << m_sessions.size ()
+                   << " frames=" << m_group.m_frameNumber << " packets=" << m_group.m_sent
+                   << " retransmits=" << m_group.m_retransmitted
+                   << " expired=" << m_group.m_retransmit.GetDropped ());
+    }
+
+  if (m_fecGroup > 0 && m_sent > 0)
+    {
+      NS_LOG_INFO ("FecLog::Parity " << m_paritySent << " packets for " << m_sent
+                   << " data packets, " << 100.0 * m_paritySent / m_sent << "% overhead");
+    }
 }
 
 void 
@@ -148,6 +297,36 @@ StreamingStreamer::GetDataSize (void) const
   return m_size;
 }
 
+StreamingSession&
+StreamingStreamer::GetSession (const Address &address)
+{
+  std::map<Address, StreamingSession>::iterator iter = m_sessions.find (address);
+  if (iter != m_sessions.end ())
+    return iter->second;
+
+  NS_LOG_INFO ("New client " << InetSocketAddress::ConvertFrom (address).GetIpv4 ()
+               << ", " << m_sessions.size () + 1 << " sessions");
+  StreamingSession &session = m_sessions[address];
+  session.m_address = address;
+  session.m_retransmit.SetHoldOff (m_retransmitHoldOff);
+  session.m_quality = m_ladder.size () - 1;
+  session.m_targetQuality = session.m_quality;
+  if (!m_rateControllerType.empty ())
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (m_rateControllerType);
+      session.m_rateController = factory.Create<StreamingRateController> ();
+    }
+  return session;
+}
+
+uint32_t
+StreamingStreamer::RetransmitDeadlineSeq (const StreamingSession &session) const
+{
+  // packets of earlier frames cannot reach the client before playout
+  return session.FrameFirstSeq (session.m_currentFrame + m_retransmitLead);
+}
+
 void 
 StreamingStreamer::ScheduleTx (Time dt)
 {
@@ -163,90 +342,296 @@ StreamingStreamer::SendPacket (void)
   NS_ASSERT (m_sendEvent.IsExpired ());
 
 
-	if (!m_pause)
+	if (m_multicast)
 	{
-		uint32_t retransmit_count=0;
-		if (retransmit_queue.size()>0){
-			std::unique(retransmit_queue.begin(), retransmit_queue.end());
-
-			std::deque<uint32_t>::iterator iter;
-			for(iter=retransmit_queue.begin();iter!=retransmit_queue.end();)
-			{
-				if (*iter < currentFrame*100)
-				{
-					iter = retransmit_queue.erase(iter);
-				}
-				else
-				{
-					iter++;
-				}
-			}
-
-			for(uint32_t i=0;i<100;i++)
-			{
-				if (retransmit_queue.empty())
-					break;
-				retransmit_count++;
-				uint32_t retransmit_packet = retransmit_queue.front();
-				Ptr<Packet> p;
-				p = Create<Packet> (m_size);
-				Address localAddress;
-				m_socket->GetSockName (localAddress);
-				SeqTsHeader seqTs;	
-				seqTs.SetSeq (retransmit_packet);
-				p->AddHeader (seqTs);
-				m_socket->Send (p);
-				retransmit_queue.pop_front();
-			}
+		// every receiver shares the one group stream
+		if (!m_sessions.empty ())
+		{
+			UpdateGroup ();
+			SendFrame (m_group);
+		}
+	}
+	else
+	{
+		// one scheduler fans the frame tick out to every client
+		std::map<Address, StreamingSession>::iterator iter;
+		for (iter = m_sessions.begin (); iter != m_sessions.end (); ++iter)
+		{
+			// a TCP client gets frames once its connection is accepted
+			if (m_tcp && iter->second.m_socket == 0)
+				continue;
+			SendFrame (iter->second);
 		}
+	}
 
-		for (uint32_t i=0; i<m_fpacketN; i++)
+	// Packet Log
+	/*
+	if (Ipv4Address::IsMatchingType (m_peerAddress))
+	{
+		NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s streamer sent " << m_size << " bytes to " <<
+			Ipv4Address::ConvertFrom (m_peerAddress) << " port " << m_peerPort);
+	}
+	else if (InetSocketAddress::IsMatchingType (m_peerAddress))
 		{
-			Ptr<Packet> p;
-			p = Create<Packet> (m_size);
+			NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s streamer sent " << m_size << " bytes to " <<
+		InetSocketAddress::ConvertFrom (m_peerAddress).GetIpv4 () << " port " << InetSocketAddress::ConvertFrom (m_peerAddress).GetPort ());
+	}
+	*/
+
+	m_sendEvent = Simulator::Schedule ( Seconds ((double)1.0/m_fps), &StreamingStreamer::SendPacket, this);
+
+	if (m_pacing)
+	{
+		NS_LOG_LOGIC ("PacingQueue: " << m_txQueue.size ());
+		if (!m_paceEvent.IsRunning ())
+			SendPaced ();
+	}
+}
+
+void
+StreamingStreamer::SendFrame (StreamingSession &session)
+{
+	session.PruneHistory (session.m_currentFrame + m_retransmitLead);
 
-			Address localAddress;
-			m_socket->GetSockName (localAddress);
+	// repairs do not grow the client's buffer, so they go out without credit
+	SendRetransmits (session);
+
+	// a frame interval's worth of bytes at the controlled rate, with at
+	// most one interval banked; repairs and parity draw on it too
+	DataRate rate = GetSendRate (session);
+	double interval = rate.GetBitRate () / 8.0 / m_fps;
+	session.m_sendBudget = rate.GetBitRate () > 0 ? std::min (session.m_sendBudget + interval, interval) : 0;
+
+	if (session.m_frameNumber < session.m_creditLimit && (rate.GetBitRate () == 0 || session.m_sendBudget > 0))
+	{
 
-			SeqTsHeader seqTs;	
-			seqTs.SetSeq (m_seqNumber++);
-			p->AddHeader (seqTs);
+		// quality switches take effect at frame boundaries
+		session.m_quality = session.m_targetQuality;
+		if (rate.GetBitRate () > 0)
+		{
+			// no higher than the rate sustains, whatever the client asked for
+			while (session.m_quality > 0 && m_ladder[session.m_quality] * m_size * 8.0 * m_fps > rate.GetBitRate ())
+				session.m_quality--;
+		}
+		uint32_t packets = m_ladder[session.m_quality];
+		uint32_t bytes = packets * m_size;
+		uint8_t type = FrameTrace::FRAME_I;
+		if (!m_frameTrace.IsEmpty ())
+		{
+			// lower levels scale the trace by their share of the top level
+			const FrameTrace::Entry &entry = m_frameTrace.Get (session.m_frameNumber);
+			bytes = (uint64_t)entry.bytes * m_ladder[session.m_quality] / m_ladder.back ();
+			type = entry.type;
+			packets = std::min<uint32_t> (65535, std::max<uint32_t> (1, (bytes + m_size - 1) / m_size));
+		}
+		const StreamingSession::SentFrame &frame = session.NewFrame (packets, session.m_quality, type, bytes);
 
-			m_socket->Send (p);
+		for (uint32_t i=0; i<frame.packets; i++)
+		{
+			EmitPacket (&session, frame.firstSeq + i, false, session.m_address);
 			++m_sent;
+			++session.m_sent;
+
+			if (m_fecGroup > 0 && ((i + 1) % m_fecGroup == 0 || i + 1 == frame.packets))
+			{
+				// parity over the group just sent, addressed by its first sequence
+				EmitPacket (&session, frame.firstSeq + (i / m_fecGroup) * m_fecGroup, true, session.m_address);
+				++m_paritySent;
+			}
 
 			// packet log
 			/*
-			if (Ipv4Address::IsMatchingType (m_peerAddress))
+			if (Ipv4Address::IsMatchingType (session.m_address))
 			{
 				NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s streamer sent " << m_size << " bytes to " <<
-					Ipv4Address::ConvertFrom (m_peerAddress) << " port " << m_peerPort);
+					Ipv4Address::ConvertFrom (session.m_address));
 			}
-			else if (InetSocketAddress::IsMatchingType (m_peerAddress))
+			else if (InetSocketAddress::IsMatchingType (session.m_address))
 				{
 					NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s streamer sent " << m_size << " bytes to " <<
-				InetSocketAddress::ConvertFrom (m_peerAddress).GetIpv4 () << " port " << InetSocketAddress::ConvertFrom (m_peerAddress).GetPort ());
+				InetSocketAddress::ConvertFrom (session.m_address).GetIpv4 () << " port " << InetSocketAddress::ConvertFrom (session.m_address).GetPort ());
 			}
 			*/
 		}
 	}
+}
 
-	// Packet Log
-	/*
-	if (Ipv4Address::IsMatchingType (m_peerAddress))
+void
+StreamingStreamer::SendRetransmits (StreamingSession &session)
+{
+	uint32_t deadline = RetransmitDeadlineSeq (session);
+	session.m_retransmit.DropBelow (deadline);
+	m_repairRequesters.erase (m_repairRequesters.begin (), m_repairRequesters.lower_bound (deadline));
+
+	uint32_t retransmit_count=0;
+	uint32_t retransmit_packet;
+	while (retransmit_count < 100 && session.m_retransmit.Dequeue (retransmit_packet, Simulator::Now ()))
 	{
-		NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s streamer sent " << m_size << " bytes to " <<
-			Ipv4Address::ConvertFrom (m_peerAddress) << " port " << m_peerPort);
+		retransmit_count++;
+		if (!m_multicast)
+		{
+			session.m_retransmitted++;
+			m_retransmitTrace (retransmit_packet, false);
+			EmitPacket (&session, retransmit_packet, false, session.m_address);
+			continue;
+		}
+
+		std::map<uint32_t, std::vector<StreamingSession*> >::iterator req = m_repairRequesters.find (retransmit_packet);
+		if (req == m_repairRequesters.end ())
+			continue;
+
+		if (req->second.size () >= m_repairThreshold)
+		{
+			// one multicast repair serves every receiver that lost it
+			session.m_retransmitted++;
+			m_retransmitTrace (retransmit_packet, true);
+			EmitPacket (&session, retransmit_packet, false, session.m_address);
+		}
+		else
+		{
+			for (uint32_t i = 0; i < req->second.size (); i++)
+			{
+				req->second[i]->m_retransmitted++;
+				m_retransmitTrace (retransmit_packet, false);
+				EmitPacket (&session, retransmit_packet, false, req->second[i]->m_address);
+			}
+		}
+		m_repairRequesters.erase (req);
 	}
-	else if (InetSocketAddress::IsMatchingType (m_peerAddress))
+}
+
+void
+StreamingStreamer::UpdateGroup (void)
+{
+	// the group runs while any receiver has credit, follows the slowest
+	// playout position and the lowest requested quality
+	uint32_t creditLimit = 0;
+	uint32_t currentFrame = m_group.m_frameNumber;
+	uint8_t quality = m_ladder.size () - 1;
+	std::map<Address, StreamingSession>::const_iterator iter;
+	for (iter = m_sessions.begin (); iter != m_sessions.end (); ++iter)
+	{
+		creditLimit = std::max (creditLimit, iter->second.m_creditLimit);
+		currentFrame = std::min (currentFrame, iter->second.m_currentFrame);
+		quality = std::min (quality, iter->second.m_targetQuality);
+	}
+	m_group.m_creditLimit = creditLimit;
+	m_group.m_currentFrame = currentFrame;
+	m_group.m_targetQuality = quality;
+}
+
+DataRate
+StreamingStreamer::GetSendRate (const StreamingSession &session) const
+{
+	if (m_multicast && &session == &m_group)
+	{
+		// the group goes no faster than its slowest receiver's controller
+		uint64_t rate = 0;
+		std::map<Address, StreamingSession>::const_iterator iter;
+		for (iter = m_sessions.begin (); iter != m_sessions.end (); ++iter)
 		{
-			NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s streamer sent " << m_size << " bytes to " <<
-		InetSocketAddress::ConvertFrom (m_peerAddress).GetIpv4 () << " port " << InetSocketAddress::ConvertFrom (m_peerAddress).GetPort ());
+			if (iter->second.m_rateController == 0)
+				continue;
+			uint64_t bps = iter->second.m_rateController->GetRate ().GetBitRate ();
+			rate = (rate == 0) ? bps : std::min (rate, bps);
+		}
+		return DataRate (rate);
 	}
-	*/
+	if (session.m_rateController == 0)
+		return DataRate (0);
+	return session.m_rateController->GetRate ();
+}
 
-	m_sendEvent = Simulator::Schedule ( Seconds ((double)1.0/m_fps), &StreamingStreamer::SendPacket, this);
+void
+StreamingStreamer::EmitPacket (StreamingSession *session, uint32_t seq, bool parity, const Address &to)
+{
+	session->m_sendBudget -= m_size;
+	if (m_pacing)
+	{
+		TxEntry entry;
+		entry.session = session;
+		entry.seq = seq;
+		entry.parity = parity;
+		entry.to = to;
+		m_txQueue.push_back (entry);
+		m_txQueueLength = m_txQueue.size ();
+	}
+	else
+	{
+		SendSeq (session, seq, parity, to);
+	}
+}
+
+void
+StreamingStreamer::SendSeq (StreamingSession *session, uint32_t seq, bool parity, const Address &to)
+{
+	const StreamingSession::SentFrame *frame = session->FindFrame (seq);
+	if (frame == 0)
+	{
+		NS_LOG_LOGIC ("No frame for sequence " << seq);
+		return;
+	}
+
+	uint32_t packetIdx = seq - frame->firstSeq;
+	// the last packet carries what is left of the frame; parity covers a full packet
+	uint32_t size = m_size;
+	if (!parity && packetIdx + 1 == frame->packets && frame->bytes > packetIdx * m_size)
+		size = std::min (m_size, frame->bytes - packetIdx * m_size);
+
+	Ptr<Packet> p;
+	p = Create<Packet> (size);
+
+	FrameHeader frameHeader;
+	frameHeader.Set (frame->frameIdx, parity ? packetIdx / m_fecGroup : packetIdx, frame->packets, frame->quality);
+	frameHeader.SetFec (m_fecGroup, parity);
+	frameHeader.SetFrameInfo (frame->type, frame->bytes);
+	p->AddHeader (frameHeader);
+
+	SeqTsHeader seqTs;	
+	seqTs.SetSeq (seq);
+	p->AddHeader (seqTs);
+
+	if (m_tcp)
+	{
+		StreamFramer::AddLength (p);
+		session->m_backlog.push_back (std::make_pair (seq, p));
+		SendStream (*session);
+		return;
+	}
+	m_socket->SendTo (p, 0, to);
+}
+
+void
+StreamingStreamer::SendPaced (void)
+{
+	// packets the client can no longer play out are not worth the airtime
+	while (!m_txQueue.empty () && m_txQueue.front ().seq < RetransmitDeadlineSeq (*m_txQueue.front ().session))
+	{
+		m_txQueue.pop_front ();
+	}
+
+	if (!m_txQueue.empty ())
+	{
+		const TxEntry &entry = m_txQueue.front ();
+		SendSeq (entry.session, entry.seq, entry.parity, entry.to);
+		m_txQueue.pop_front ();
+	}
+	m_txQueueLength = m_txQueue.size ();
+
+	if (m_txQueue.empty ())
+		return;
 
+	Time gap;
+	if (m_pacingRate.GetBitRate () > 0)
+	{
+		gap = m_pacingRate.CalculateBytesTxTime (m_size);
+	}
+	else
+	{
+		// drain what is queued evenly before the next frame tick
+		gap = Simulator::GetDelayLeft (m_sendEvent) / (uint64_t)m_txQueue.size ();
+	}
+	m_paceEvent = Simulator::Schedule (gap, &StreamingStreamer::SendPaced, this);
 }
 
 void
@@ -268,46 +653,139 @@ StreamingStreamer::HandleRead (Ptr<Socket> socket)
 		InetSocketAddress::ConvertFrom (from).GetPort ());
 		*/
 
-		if (m_lossEnable)
+		if (m_tcp)
 		{
-			double prob = (double)rand() / RAND_MAX;
-			if (prob <= m_errorRate)
-				continue;
+			// reports arrive length-framed on the client's connection
+			StreamFramer &framer = GetSession (from).m_framer;
+			framer.Push (packet);
+			Ptr<Packet> report;
+			while ((report = framer.Pop ()))
+				HandleReport (from, report);
+		}
+		else if (m_errorModel != 0 && m_errorModel->IsCorrupt (packet))
+		{
+			NS_LOG_LOGIC ("Report dropped by the receive error model");
 		}
+		else
+		{
+			HandleReport (from, packet);
+		}
+    }
+    socket->GetSockName (localAddress);
+	}
+}
 
-		//dongwon
-		ClientHeader header;
-		packet->RemoveHeader (header);
-		uint8_t state = header.GetState();
-		uint16_t currentFrame = header.GetCurrentFrame ();
-		uint32_t* requests =  header.GetRetransmitRequest ();
-		
-		if (state == 1)  // pause packet
-			m_pause = true;
-		else if (state == 2)  // resume packet
-			m_pause = false;
-		else if (state == 0)  // retransmit request packet
+void
+StreamingStreamer::HandleReport (const Address &from, Ptr<Packet> packet)
+{
+	//dongwon
+	StreamingSession &session = GetSession (from);
+	ClientHeader header;
+	packet->RemoveHeader (header);
+	session.m_currentFrame = header.GetPlayoutFrame ();
+	if (header.GetQuality () != ClientHeader::QUALITY_ANY)
+	{
+		session.m_targetQuality = std::min<uint32_t> (header.GetQuality (), m_ladder.size () - 1);
+	}
+	session.m_bufferLevel = header.GetBufferLevel ();
+	session.m_receiveRate = (uint64_t)header.GetReceiveRate () * 1000;
+	if (header.GetEchoTimestamp () != 0)
+	{
+		// RTT = now - echoed send time - time the client held it, in us modulo 2^32
+		uint32_t now = Simulator::Now ().GetMicroSeconds ();
+		session.m_rtt = MicroSeconds (now - header.GetEchoTimestamp () - header.GetEchoDelay ());
+	}
+
+	if (header.GetFlags () & ClientHeader::FLAG_JOIN)
+	{
+		NS_LOG_LOGIC ("Join from " << InetSocketAddress::ConvertFrom (from).GetIpv4 ());
+		// a late multicast receiver starts at the live edge, not frame 0
+		if (m_multicast)
+			session.m_currentFrame = std::max (session.m_currentFrame, m_group.m_frameNumber);
+	}
+
+	if (header.GetNackRangeCount () > 0)
+	{
+		// multicast NACKs are aggregated in the group's queue
+		StreamingSession &stream = m_multicast ? m_group : session;
+		uint32_t deadline = stream.FrameFirstSeq (session.m_currentFrame + m_retransmitLead);
+		if (!m_multicast)
+			session.m_retransmit.DropBelow (deadline);
+		for(uint32_t i=0;i<header.GetNackRangeCount ();i++)
 		{
-			std::deque<uint32_t>::iterator iter;
-			for(iter=retransmit_queue.begin();iter!=retransmit_queue.end();)
+			uint32_t first = std::max (header.GetNackStart (i), deadline);
+			uint32_t last = header.GetNackStart (i) + header.GetNackLength (i);
+			for(uint32_t seq=first;seq<last;seq++)
 			{
-				if (*iter < currentFrame*100)
+				if (m_multicast)
 				{
-					iter = retransmit_queue.erase(iter);
+					std::vector<StreamingSession*> &requesters = m_repairRequesters[seq];
+					if (std::find (requesters.begin (), requesters.end (), &session) == requesters.end ())
+						requesters.push_back (&session);
 				}
-				else
-				{
-					iter++;
-				}
-			}
-			for(uint32_t i=0;i<100;i++){
-				if (requests[i] == 0) 
-					break;	
-				retransmit_queue.push_back(requests[i]);
+				stream.m_retransmit.Enqueue (seq, Simulator::Now ());
 			}
 		}
-    }
-    socket->GetSockName (localAddress);
+	}
+
+	// the report's window: next expected frame plus credits
+	session.m_creditLimit = session.m_currentFrame + header.GetCredits ();
+
+	// reports before data flows say nothing about the path
+	if (session.m_rateController != 0 && header.GetEchoTimestamp () != 0)
+	{
+		RateFeedback feedback;
+		feedback.now = Simulator::Now ();
+		feedback.lossFraction = header.GetLossFraction () / 256.0;
+		feedback.receiveRate = DataRate (session.m_receiveRate);
+		feedback.delay = MicroSeconds (header.GetDelay ());
+		feedback.rtt = session.m_rtt;
+		session.m_rateController->Update (feedback);
+	}
+}
+
+void
+StreamingStreamer::HandleAccept (Ptr<Socket> socket, const Address &from)
+{
+	NS_LOG_FUNCTION (this << socket << from);
+	StreamingSession &session = GetSession (from);
+	session.m_socket = socket;
+	socket->SetRecvCallback (MakeCallback (&StreamingStreamer::HandleRead, this));
+	socket->SetSendCallback (MakeCallback (&StreamingStreamer::HandleSend, this));
+}
+
+void
+StreamingStreamer::HandleSend (Ptr<Socket> socket, uint32_t available)
+{
+	std::map<Address, StreamingSession>::iterator iter;
+	for (iter = m_sessions.begin (); iter != m_sessions.end (); ++iter)
+	{
+		if (iter->second.m_socket == socket)
+		{
+			SendStream (iter->second);
+			return;
+		}
+	}
+}
+
+void
+StreamingStreamer::SendStream (StreamingSession &session)
+{
+	// TCP would deliver a late packet anyway, so drop it before it takes
+	// the place of one that still arrives in time
+	uint32_t deadline = RetransmitDeadlineSeq (session);
+	while (!session.m_backlog.empty () && session.m_backlog.front ().first < deadline)
+	{
+		session.m_backlog.pop_front ();
+	}
+
+	// a message goes out whole or not at all, so the receiver's framing
+	// never depends on a partial write
+	while (!session.m_backlog.empty ()
+	       && session.m_socket->GetTxAvailable () >= session.m_backlog.front ().second->GetSize ())
+	{
+		session.m_socket->Send (session.m_backlog.front ().second);
+		session.m_backlog.pop_front ();
 	}
 }
 }
@@ -4,12 +4,21 @@
 #include "ns3/application.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/data-rate.h"
+#include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
+#include "streaming-session.h"
+#include "frame-trace.h"
 
 #include <deque>
+#include <map>
+#include <string>
+#include <vector>
 
 namespace ns3 {
 
 class Socket;
+class ErrorModel;
 class Packet;
 
 class StreamingStreamer : public Application
@@ -18,6 +27,8 @@ public:
 	static TypeId GetTypeId (void);
 	StreamingStreamer ();
 	virtual ~StreamingStreamer ();
+
+	typedef void (* RetransmitTracedCallback)(uint32_t seq, bool multicast);
 	
 	void SetDataSize (uint32_t dataSize);
 	uint32_t GetDataSize (void) const;
@@ -27,7 +38,18 @@ private:
 
 	void ScheduleTx (Time dt);
 	void SendPacket (void);
+	void SendFrame (StreamingSession &session);
+	void SendRetransmits (StreamingSession &session);
+	void EmitPacket (StreamingSession *session, uint32_t seq, bool parity, const Address &to);
+	void SendSeq (StreamingSession *session, uint32_t seq, bool parity, const Address &to);
+	void SendPaced (void);
 	void HandleRead (Ptr<Socket> socket);
+	void HandleReport (const Address &from, Ptr<Packet> packet);
+
+	// TCP transport: one accepted connection per client
+	void HandleAccept (Ptr<Socket> socket, const Address &from);
+	void HandleSend (Ptr<Socket> socket, uint32_t available);
+	void SendStream (StreamingSession &session);
 
 	uint32_t m_size;
 	
@@ -35,19 +57,67 @@ private:
 	Ptr<Socket> m_socket;
 	Address m_peerAddress;
 	uint16_t m_peerPort;
+	uint16_t m_localPort;
+	TypeId m_tid;
+	bool m_tcp;
+	// drops report datagrams above the MAC
+	Ptr<ErrorModel> m_errorModel;
 	EventId m_sendEvent;
 
-	uint32_t m_seqNumber;
 	uint32_t m_fps;
 	uint32_t m_fpacketN;
-	bool m_pause;
 
-	bool m_lossEnable;
-	double m_errorRate;
+
+	// one session per client, keyed by its source address
+	std::map<Address, StreamingSession> m_sessions;
+	StreamingSession& GetSession (const Address &address);
+
+	// multicast: one group stream, receivers only report feedback
+	Address m_multicastGroup;
+	bool m_multicast;
+	StreamingSession m_group;
+	uint32_t m_repairThreshold;
+	// receivers waiting for each pending group retransmission
+	std::map<uint32_t, std::vector<StreamingSession*> > m_repairRequesters;
+	TracedCallback<uint32_t, bool> m_retransmitTrace;
+	void UpdateGroup (void);
 
 	//dongwon - retransmit
-	std::deque<uint32_t> retransmit_queue;
-	uint32_t currentFrame;
+	uint32_t m_retransmitLead;
+	Time m_retransmitHoldOff;
+	uint32_t RetransmitDeadlineSeq (const StreamingSession &session) const;
+
+	// pacing
+	bool m_pacing;
+	DataRate m_pacingRate;
+	struct TxEntry
+	{
+		StreamingSession *session;
+		uint32_t seq;
+		bool parity;
+		Address to;
+	};
+	std::deque<TxEntry> m_txQueue;
+	TracedValue<uint32_t> m_txQueueLength;
+	EventId m_paceEvent;
+
+	// Adaptive bitrate
+	std::string m_qualityLevels;
+	std::vector<uint32_t> m_ladder;
+
+	// trace-driven frame sizes; the top ladder level plays the trace as is
+	std::string m_frameTracePath;
+	FrameTrace m_frameTrace;
+
+	// congestion control: TypeId name of a StreamingRateController
+	// subclass created per session; empty disables rate control
+	std::string m_rateControllerType;
+	DataRate GetSendRate (const StreamingSession &session) const;
+
+	// FEC: one XOR parity packet per m_fecGroup data packets of a frame
+	double m_fecRatio;
+	uint32_t m_fecGroup;
+	uint32_t m_paritySent;
 };
 
 }
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""Parallel parameter sweep for the assn3 streaming scenario.
+
+Every combination of the grid is run once per RNG run number, each in its
+own worker process and working directory. The per-station QoE summaries
+(--qoe) are averaged per run, and the runs of each combination are merged
+into one CSV row: mean and 95% confidence half-width for every metric.
+
+Build the scenario first, then point the sweep at the binary, e.g.
+
+    ./waf build
+    python3 scratch/assn3/sweep.py --ns3-dir . --program assn3 \\
+        --error 0,2,5 --buffer 40:30:25,60:45:35 --runs 1-10 --out sweep.csv
+"""
+
+import argparse
+import csv
+import glob
+import itertools
+import json
+import math
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor, as_completed
+
+# two-sided 95% Student t quantiles by degrees of freedom
+T95 = {1: 12.706, 2: 4.303, 3: 3.182, 4: 2.776, 5: 2.571, 6: 2.447, 7: 2.365,
+       8: 2.306, 9: 2.262, 10: 2.228, 12: 2.179, 15: 2.131, 20: 2.086,
+       25: 2.060, 30: 2.042, 40: 2.021, 60: 2.000, 120: 1.980}
+
+METRICS = ["startup_delay", "stall_count", "stall_time", "frames_completed",
+           "frames_consumed", "frames_skipped", "nacked_packets",
+           "average_bitrate", "delay_mean", "delay_p95", "jitter",
+           "frame_spread_mean", "wall_clock", "events"]
+
+SUMMARY_LINE = re.compile(r"assn3: (\d+) stations, ([0-9.eE+-]+) s wall clock, (\d+) events")
+
+
+def t95 (dof):
+    if dof <= 0:
+        return float ("nan")
+    best = max (d for d in T95 if d <= dof)
+    return T95[best] if dof < 120 else 1.960
+
+
+def parse_list (text, cast):
+    return [cast (item) for item in text.split (",") if item != ""]
+
+
+def parse_runs (text):
+    # "1-10" or "1,4,7"
+    runs = []
+    for item in text.split (","):
+        if "-" in item:
+            first, last = item.split ("-")
+            runs.extend (range (int (first), int (last) + 1))
+        elif item:
+            runs.append (int (item))
+    return runs
+
+
+def parse_buffers (text):
+    # bufferSize:pauseSize:resumeSize triples
+    triples = []
+    for item in text.split (","):
+        parts = [int (v) for v in item.split (":")]
+        if len (parts) != 3:
+            raise argparse.ArgumentTypeError ("buffer entries are size:pause:resume, got " + item)
+        triples.append (tuple (parts))
+    return triples
+
+
+def find_binary (ns3_dir, program):
+    # waf names scratch programs differently across releases
+    patterns = [os.path.join (ns3_dir, "build", "scratch", program, program),
+                os.path.join (ns3_dir, "build", "scratch", program, "*" + program + "*"),
+                os.path.join (ns3_dir, "build", "scratch", "*" + program + "*")]
+    for pattern in patterns:
+        for path in sorted (glob.glob (pattern)):
+            if os.path.isfile (path) and os.access (path, os.X_OK):
+                return os.path.abspath (path)
+    return None
+
+
+def run_one (binary, env, workdir, params, extra):
+    args = [binary,
+            "--error=%g" % params["error"],
+            "--fps=%d" % params["fps"],
+            "--bufferSize=%d" % params["buffer"],
+            "--pauseSize=%d" % params["pause"],
+            "--resumeSize=%d" % params["resume"],
+            "--framePackets=%d" % params["packets"],
+            "--RngRun=%d" % params["run"],
+            "--qoe=qoe"] + extra
+    os.makedirs (workdir, exist_ok=True)
+    proc = subprocess.run (args, cwd=workdir, env=env, stdout=subprocess.PIPE,
+                           stderr=subprocess.PIPE, universal_newlines=True)
+    if proc.returncode != 0:
+        raise RuntimeError ("run failed (%d): %s\n%s" % (proc.returncode, " ".join (args),
+                                                          proc.stderr[-2000:]))
+
+    result = dict (params)
+    match = SUMMARY_LINE.search (proc.stdout)
+    if match:
+        result["wall_clock"] = float (match.group (2))
+        result["events"] = int (match.group (3))
+
+    # average the stations of this run
+    summaries = []
+    for path in sorted (glob.glob (os.path.join (workdir, "qoe-*.json"))):
+        with open (path) as f:
+            summaries.append (json.load (f))
+    for key in METRICS:
+        values = [s[key] for s in summaries if key in s]
+        if values:
+            result[key] = sum (values) / len (values)
+    return result
+
+
+def merge (results, keys):
+    groups = {}
+    for r in results:
+        groups.setdefault (tuple (r[k] for k in keys), []).append (r)
+
+    rows = []
+    for combo in sorted (groups):
+        runs = groups[combo]
+        row = dict (zip (keys, combo))
+        row["runs"] = len (runs)
+        for metric in METRICS:
+            values = [r[metric] for r in runs if metric in r]
+            if not values:
+                continue
+            mean = sum (values) / len (values)
+            if len (values) > 1:
+                var = sum ((v - mean) ** 2 for v in values) / (len (values) - 1)
+                half = t95 (len (values) - 1) * math.sqrt (var / len (values))
+            else:
+                half = float ("nan")
+            row[metric] = mean
+            row[metric + "_ci95"] = half
+        rows.append (row)
+    return rows
+
+
+def main ():
+    parser = argparse.ArgumentParser (description=__doc__,
+                                      formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument ("--ns3-dir", default=".", help="ns-3 top-level directory")
+    parser.add_argument ("--program", default="assn3", help="scratch program name")
+    parser.add_argument ("--binary", help="built scenario binary (default: search build/scratch)")
+    parser.add_argument ("--error", default="2", help="error rates in percent, comma separated")
+    parser.add_argument ("--fps", default="90", help="frame rates, comma separated")
+    parser.add_argument ("--buffer", default="40:30:25", type=parse_buffers,
+                         help="bufferSize:pauseSize:resumeSize triples, comma separated")
+    parser.add_argument ("--packets", default="100", help="packets per frame, comma separated")
+    parser.add_argument ("--runs", default="1-5", help="RNG run numbers, e.g. 1-10 or 1,3,5")
+    parser.add_argument ("--jobs", type=int, default=os.cpu_count () or 1, help="parallel workers")
+    parser.add_argument ("--workdir", help="directory for per-run output (default: temporary)")
+    parser.add_argument ("--raw", help="also write one row per run to this CSV")
+    parser.add_argument ("--out", default="sweep.csv", help="merged CSV")
+    parser.add_argument ("extra", nargs="*", help="further arguments passed to every run")
+    opts = parser.parse_args ()
+
+    binary = opts.binary or find_binary (opts.ns3_dir, opts.program)
+    if not binary:
+        sys.exit ("cannot find the %s binary under %s/build; build it first or pass --binary"
+                  % (opts.program, opts.ns3_dir))
+
+    env = dict (os.environ)
+    libdirs = [os.path.abspath (os.path.join (opts.ns3_dir, "build", "lib")),
+               os.path.abspath (os.path.join (opts.ns3_dir, "build"))]
+    env["LD_LIBRARY_PATH"] = os.pathsep.join (libdirs + [env.get ("LD_LIBRARY_PATH", "")])
+
+    grid = []
+    for error, fps, (size, pause, resume), packets, run in itertools.product (
+            parse_list (opts.error, float), parse_list (opts.fps, int), opts.buffer,
+            parse_list (opts.packets, int), parse_runs (opts.runs)):
+        grid.append ({"error": error, "fps": fps, "buffer": size, "pause": pause,
+                      "resume": resume, "packets": packets, "run": run})
+
+    root = opts.workdir or tempfile.mkdtemp (prefix="assn3-sweep-")
+    print ("%d runs on %d workers, output under %s" % (len (grid), opts.jobs, root))
+
+    results = []
+    failures = 0
+    start = time.time ()
+    with ThreadPoolExecutor (max_workers=opts.jobs) as pool:
+        futures = {}
+        for i, params in enumerate (grid):
+            workdir = os.path.join (root, "run-%05d" % i)
+            futures[pool.submit (run_one, binary, env, workdir, params, opts.extra)] = params
+        for done, future in enumerate (as_completed (futures), 1):
+            try:
+                results.append (future.result ())
+            except Exception as e:
+                failures += 1
+                print (e, file=sys.stderr)
+            print ("[%d/%d] %.0f s" % (done, len (grid), time.time () - start), file=sys.stderr)
+
+    keys = ["error", "fps", "buffer", "pause", "resume", "packets"]
+    if opts.raw:
+        with open (opts.raw, "w", newline="") as f:
+            writer = csv.DictWriter (f, fieldnames=keys + ["run"] + METRICS, extrasaction="ignore")
+            writer.writeheader ()
+            writer.writerows (sorted (results, key=lambda r: [r[k] for k in keys + ["run"]]))
+
+    rows = merge (results, keys)
+    fields = keys + ["runs"]
+    for metric in METRICS:
+        fields += [metric, metric + "_ci95"]
+    with open (opts.out, "w", newline="") as f:
+        writer = csv.DictWriter (f, fieldnames=fields, extrasaction="ignore")
+        writer.writeheader ()
+        writer.writerows (rows)
+
+    print ("%d combinations written to %s, %d failed runs" % (len (rows), opts.out, failures))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit (main ())